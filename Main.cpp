@@ -14,26 +14,43 @@
 #include <EEPROM.h>
 #include <Ethernet.h>
 #include <FastLED.h>
-#include <SimpleDHT.h>
 #include <SPI.h>
 #include <Wire.h>
 #include <LiquidCrystal.h>
 
 #include "output.h"
+#include "config_store.h"
+#include "eeprom_cache.h"
 #include "rtc_control.h"
 #include "led_control.h"
 #include "dht_control.h"
 #include "network_control.h"
+#include "binary_protocol.h"
 #include "lcd_ui.h"
+#include "scheduler.h"
+#include "tokenizer.h"
 #include "token_definitions.h"
 
 #define BAUD_RATE 9600
+// Command polling periods in ms. 9600 baud fills the 64 byte RX buffer in
+//  ~66ms so this keeps well ahead of it.
+#define CLI_POLL_DELAY 10
+#define UDP_POLL_DELAY 10
+// Free TX ring a paged reply waits for before printing its next line, at
+//  least the longest line (EEPROM stats in tasks)
+#define PAGE_ROOM 80
+// Paged replies over UDP start a new packet past this, the W5100 only
+//  buffers 2KB per socket
+#define UDP_PAGE_BYTES 1024
 /*
     EEPROM Usage:
         0 ..... 246 dht_control's temperature logs
-        247 ... 272 network_control's saved addresses and such
-        273 ... 279 dht_control's saved alarm thresholds
+        247 ... 280 Settings from before the config block, erased once
+                    migrated. Addresses to 272, alarm thresholds to 280.
+        281 ... 298 dht_log's statistics summary
+        300 ... 335 config_store's settings block
 */
+#define EEPROM_CONFIG 300
 
 #define DEBUG 0
 /*  0..... no debug output
@@ -59,40 +76,31 @@ struct key_byte {
 #define NUL '\0'
 #define l_SENTENCE 23 // Longest valid command len 18 "add -32765 -32765\0"
 #define l_WORD 10 // Longest token len 8 "version\0"
-#define l_TOKEN_BUFFER 8 // RGB BYTE 255 BYTE 255 BYTE 255 EOL
+#define l_PATH 3 // Longest keyword path "dht log clear"
+#define l_ARGS 3 // Most arguments "rgb 1 2 3"
 
-#define RGB_POWER_ON_LIGHT 1 
+// Argument slot types
+#define ARG_BYTE t_BYTE // 0-255
+#define ARG_WORD t_WORD // 0-65535, bytes are accepted too
 
-// A row in our lookup table.
-// Each piece limited to the size of a byte.
-struct LookupEntry {
-    char char1, char2;
-    uint8_t length:3; // 1-7... 3 bits
-    uint8_t token:6; // 0-28... 5 bits
-};
-// The lookup table itself
-LookupEntry lookupTable[19] = {
-    {'b','l', 5, t_BLINK},
-    {'c','l', 5, t_CLEAR},
-    {'d','a', 4, t_DATE},
-    {'d','h', 3, t_DHT},
-    {'g','r', 5, t_GREEN},
-    {'h','e', 4, t_HELP},
-    {'i','n', 4, t_INFO},
-    {'l','e', 3, t_LED},
-    {'l','o', 3, t_LOG},
-    {'m','o', 7, t_MONITOR},
-    {'o','f', 3, t_OFF},
-    {'o','n', 2, t_ON},
-    {'r','e', 3, t_RED},
-    {'r','g', 3, t_RGB},
-    {'t','e', 5, t_SCALE},
-    {'s','e', 3, t_SET},
-    {'t','i', 4, t_TIME},
-    {'v','e', 7, t_VERSION},
-    {'y','e', 6, t_YELLOW}
+// Handlers get the last keyword of the path and the argument values
+typedef void (*command_fn)(uint8_t, const uint16_t*);
+
+// Prints line n of a long reply, returns false once past the last line
+typedef bool (*page_fn)(uint16_t);
+
+// A row in the command table. Unused path and arg slots hold t_EOL.
+struct command_entry {
+    uint8_t path[l_PATH];
+    uint8_t args[l_ARGS];
+    command_fn handler;
 };
 
+#define RGB_POWER_ON_LIGHT 1 
+
+task_scheduler TASKS;
+eeprom_cache EECACHE;
+config_store CONFIG;
 led_control LED;
 rtc_control RTC;
 dht_control DHT;
@@ -115,14 +123,71 @@ uint8_t token_length = 0;
 // Used for certain functions to halt processing
 bool error_flag = false;
 
+// Long serial replies are printed a line at a time as the TX ring drains
+page_fn pager = NULL;
+uint16_t page_line = 0;
+uint8_t page_task = TASK_NONE;
+
 word atot(char*, uint8_t);
 bool capturableByte(byte);
+void cliTask(void*);
 void commandError();
+bool helpLine(uint16_t);
+bool ledLine(uint16_t);
+bool logLine(uint16_t);
+bool logInfoLine(uint16_t);
+bool tasksLine(uint16_t);
+bool matchCommand(const command_entry&, uint8_t*, uint16_t*);
+void pageTask(void*);
 void parseInput(char*, uint8_t);
 void parseTokens();
+void printPaged(page_fn);
 bool processInput();
 void resetInputBuffer();
 key_byte s_readChar();
+void udpTask(void*);
+
+void cmdDhtLog(uint8_t, const uint16_t*);
+void cmdDhtMonitor(uint8_t, const uint16_t*);
+void cmdDhtStatus(uint8_t, const uint16_t*);
+void cmdHelp(uint8_t, const uint16_t*);
+void cmdLedColor(uint8_t, const uint16_t*);
+void cmdLedLight(uint8_t, const uint16_t*);
+void cmdLedRGB(uint8_t, const uint16_t*);
+void cmdLedStatus(uint8_t, const uint16_t*);
+void cmdSetBlink(uint8_t, const uint16_t*);
+void cmdSetClock(uint8_t, const uint16_t*);
+void cmdSetScale(uint8_t, const uint16_t*);
+void cmdTasks(uint8_t, const uint16_t*);
+void cmdTime(uint8_t, const uint16_t*);
+void cmdVersion(uint8_t, const uint16_t*);
+
+// The command grammar, see matchCommand()
+const command_entry commands[] PROGMEM = {
+    // path                      args                            handler
+    {{t_LED, t_EOL, t_EOL},     {t_EOL, t_EOL, t_EOL},          cmdLedStatus},
+    {{t_LED, t_ON, t_EOL},      {t_EOL, t_EOL, t_EOL},          cmdLedLight},
+    {{t_LED, t_OFF, t_EOL},     {t_EOL, t_EOL, t_EOL},          cmdLedLight},
+    {{t_LED, t_BLINK, t_EOL},   {t_EOL, t_EOL, t_EOL},          cmdLedLight},
+    {{t_LED, t_RED, t_EOL},     {t_EOL, t_EOL, t_EOL},          cmdLedColor},
+    {{t_LED, t_GREEN, t_EOL},   {t_EOL, t_EOL, t_EOL},          cmdLedColor},
+    {{t_LED, t_YELLOW, t_EOL},  {t_EOL, t_EOL, t_EOL},          cmdLedColor},
+    {{t_LED, t_EOL, t_EOL},     {ARG_BYTE, ARG_BYTE, ARG_BYTE}, cmdLedRGB},
+    {{t_DHT, t_EOL, t_EOL},     {t_EOL, t_EOL, t_EOL},          cmdDhtStatus},
+    {{t_DHT, t_MONITOR, t_EOL}, {t_EOL, t_EOL, t_EOL},          cmdDhtMonitor},
+    {{t_DHT, t_LOG, t_EOL},     {t_EOL, t_EOL, t_EOL},          cmdDhtLog},
+    {{t_DHT, t_LOG, t_INFO},    {t_EOL, t_EOL, t_EOL},          cmdDhtLog},
+    {{t_DHT, t_LOG, t_CLEAR},   {t_EOL, t_EOL, t_EOL},          cmdDhtLog},
+    {{t_TIME, t_EOL, t_EOL},    {t_EOL, t_EOL, t_EOL},          cmdTime},
+    {{t_DATE, t_EOL, t_EOL},    {t_EOL, t_EOL, t_EOL},          cmdTime},
+    {{t_SET, t_TIME, t_EOL},    {ARG_BYTE, ARG_BYTE, ARG_BYTE}, cmdSetClock},
+    {{t_SET, t_DATE, t_EOL},    {ARG_BYTE, ARG_BYTE, ARG_BYTE}, cmdSetClock},
+    {{t_SET, t_BLINK, t_EOL},   {ARG_WORD, t_EOL, t_EOL},       cmdSetBlink},
+    {{t_SET, t_DHT, t_SCALE},   {ARG_BYTE, t_EOL, t_EOL},       cmdSetScale},
+    {{t_TASKS, t_EOL, t_EOL},   {t_EOL, t_EOL, t_EOL},          cmdTasks},
+    {{t_VERSION, t_EOL, t_EOL}, {t_EOL, t_EOL, t_EOL},          cmdVersion},
+    {{t_HELP, t_EOL, t_EOL},    {t_EOL, t_EOL, t_EOL},          cmdHelp}
+};
 
 // ====== //
 // Intitial setup function
@@ -131,6 +196,9 @@ void setup() {
     while (!Serial) {
         ; // wait for serial port to connect. Needed for native USB port only
     }
+    out.setup();
+    EECACHE.setup();
+    CONFIG.load(EEPROM_CONFIG);
     #if DEBUG >= 1
     Serial.println(F("Program start."));
     #endif
@@ -144,15 +212,41 @@ void setup() {
     LED.setRGBColor(RGB_POWER_ON_LIGHT, 0, 50, 0);
 
     LCD_UI.setup();
+
+    TASKS.add(F("cli"), cliTask, NULL, CLI_POLL_DELAY);
+    TASKS.add(F("udp"), udpTask, NULL, UDP_POLL_DELAY);
+    page_task = TASKS.add(F("page"), pageTask, NULL, 0);
+    TASKS.stop(page_task);
+    // A task that didn't fit would silently never run
+    if (TASKS.refusedCount()) {
+        Serial.print(F("Task table full, not started: "));
+        Serial.println(TASKS.refusedCount());
+    }
 }
 
-// Looping routine with core functions
+// Looping routine, runs whichever module tasks are due
 void loop() {
-    LED.loop();
-    DHT.loop();
+    TASKS.loop();
+    // Whatever the tasks changed goes out to the strip in one frame
+    LED.show();
+}
 
-    // Process Command Line Input
-    if (processInput()) {
+// ============================== //
+// Returns true if it's a character we wish to save to input buffer
+bool capturableByte(byte b) {
+    return (isAlphaNumeric(b) ||
+            isSpace(b) ||
+            b == HYPHEN_BYTE);
+}
+
+// Process Command Line Input, everything received since the last poll
+void cliTask(void*) {
+    // Input waits in the RX buffer until a paged reply is done
+    if (pager != NULL)
+        return;
+    while (Serial.available() > 0) {
+        if (!processInput())
+            continue;
         parseInput(input_buffer, input_length);
         #if DEBUG >= 1
         Serial.print("CLI Token buffer: ");
@@ -164,13 +258,24 @@ void loop() {
         Serial.println(token_length);
         #endif
         parseTokens();
+        if (pager != NULL)
+            return; // Prompt comes once the pager finishes
+        out.flush();
         resetInputBuffer();
     }
+}
 
-    // Process incoming network input
-    if (NET.loop()) {
+// Process incoming network input
+void udpTask(void*) {
+    if (NET.receive()) {
+        uint8_t len = min(NET.getPacketBufferLength(), UDP_TX_PACKET_MAX_SIZE);
+        if (isBinaryFrame(NET.getPacketBuffer(), len)) {
+            // Machine clients skip the tokenizer and text output entirely
+            handleBinaryFrame(NET.getPacketBuffer(), len);
+            return;
+        }
         out.udpBegin();
-        parseInput(NET.getPacketBuffer(), NET.getPacketBufferLength());
+        parseInput(NET.getPacketBuffer(), len);
         #if DEBUG >= 1
         Serial.print("Network Token buffer: ");
         for (int i=0; i<l_TOKEN_BUFFER; i++) {
@@ -185,16 +290,35 @@ void loop() {
         parseTokens();
         out.udpEnd();
     }
+}
 
-    LCD_UI.loop();
+// Run a long reply through the pager. Over UDP there is nothing to wait
+//  for, it just gets split into packets the shield can hold.
+void printPaged(page_fn fn) {
+    if (out.udp_print) {
+        for (uint16_t n = 0; fn(n); n++) {
+            if (out.udp_bytes > UDP_PAGE_BYTES) {
+                out.udpEnd();
+                out.udpBegin();
+            }
+        }
+        return;
+    }
+    pager = fn;
+    page_line = 0;
+    TASKS.wake(page_task);
 }
 
-// ============================== //
-// Returns true if it's a character we wish to save to input buffer
-bool capturableByte(byte b) {
-    return (isAlphaNumeric(b) ||
-            isSpace(b) ||
-            b == HYPHEN_BYTE);
+// Print lines while the TX ring has room, then wait for it to drain
+void pageTask(void*) {
+    while (out.availableForWrite() >= PAGE_ROOM) {
+        if (!pager(page_line++)) {
+            pager = NULL;
+            resetInputBuffer();
+            return;
+        }
+    }
+    TASKS.wake(page_task, TX_DRAIN_DELAY);
 }
 
 // Prints an error line fr when CLI 
@@ -260,7 +384,7 @@ void parseInput(char* input, uint8_t length) {
     char word[l_WORD];
     token_length = 0;
     uint8_t i = 0, c = 0;
-    bool save_int = false;
+    bool save_int = false, overflow = false;
     // Read chars until we reach the end of the input
     while (i <= length) {
         #if DEBUG >= 4
@@ -269,7 +393,9 @@ void parseInput(char* input, uint8_t length) {
         #endif
         // If it is a non-space char we save it off
         if (input[i] != ' ' && input[i] != NUL) {
-            word[c++] = input[i];
+            // Overlong words are cut short, they can't be keywords anyway
+            if (c < l_WORD - 1)
+                word[c++] = input[i];
         }
         else {
             // We hit a space or eol and can end our current word
@@ -278,37 +404,35 @@ void parseInput(char* input, uint8_t length) {
             Serial.print(F("parseInput while loop word: "));
             Serial.println(word);
             #endif
-            if (c >= 2) {
-                // Check list of tokens for a match
-                for (LookupEntry e : lookupTable) {
-                    if (word[0] == e.char1 &&
-                        word[1] == e.char2 &&
-                        strlen(word) == e.length) {
-                            token_buffer[token_length++] = e.token;
-                            #if DEBUG >= 8990
-                            Serial.print(F("Token found: "));
-                            Serial.println(e.token);
-                            #endif
-                            // Reset by zeroing out relevant data
-                            c = 0;
-                            word[0] = word[1] = NUL;
-                            // Special case token
-                            // Any of these tokens, when encountered, will
-                            // Attempt to convert unknown text in the input buffer
-                            // into a word or byte to store in the token buffer
-                            switch (e.token) {
-                                case t_WORD:
-                                case t_BYTE:
-                                case t_SET:
-                                case t_RGB:
-                                case t_LED:
-                                    #if DEBUG >= 3
-                                    Serial.println(F("save int flag set"));
-                                    #endif
-                                    save_int = true;
-                            }
-                            break;
-                    }
+            // Check the keyword table for a match
+            uint8_t token = lookupToken(word, c);
+            if (token != TOKEN_NONE) {
+                // Always leave room for the EOL
+                if (token_length < l_TOKEN_BUFFER - 1)
+                    token_buffer[token_length++] = token;
+                else
+                    overflow = true;
+                #if DEBUG >= 8990
+                Serial.print(F("Token found: "));
+                Serial.println(token);
+                #endif
+                // Reset by zeroing out relevant data
+                c = 0;
+                word[0] = word[1] = NUL;
+                // Special case token
+                // Any of these tokens, when encountered, will
+                // Attempt to convert unknown text in the input buffer
+                // into a word or byte to store in the token buffer
+                switch (token) {
+                    case t_WORD:
+                    case t_BYTE:
+                    case t_SET:
+                    case t_RGB:
+                    case t_LED:
+                        #if DEBUG >= 3
+                        Serial.println(F("save int flag set"));
+                        #endif
+                        save_int = true;
                 }
             }
             // If word still exists, no token was found...
@@ -323,6 +447,9 @@ void parseInput(char* input, uint8_t length) {
                     default:
                         word_num = atot(word, c);
                         if ( error_flag );
+                        else if (token_length + (highByte(word_num)? 3: 2) >=
+                                l_TOKEN_BUFFER)
+                            overflow = true;
                         else if (highByte(word_num) == 0) {
                             token_buffer[token_length++] = t_BYTE;
                             token_buffer[token_length++] = lowByte(word_num);
@@ -344,134 +471,37 @@ void parseInput(char* input, uint8_t length) {
     #if DEBUG >= 2
     Serial.println(F("parseInput end"));
     #endif
+    // Too many tokens to be any command
+    if (overflow)
+        token_length = 0;
     token_buffer[token_length] = t_EOL;
 }
 
-// Read the token buffer and perform the appropriate action
+// Match the token buffer against the command table and run the handler
 void parseTokens() {
     if (token_length == 0) {
         commandError();
         return;
     }
-    // Branch to options
-    switch (token_buffer[0]) {
-        case t_LED:
-        case t_RGB:
-            switch (token_buffer[1]) {
-                case t_EOL:
-                    LED.printStatus();
-                    break;
-                case t_ON:
-                case t_OFF:
-                case t_BLINK:
-                    LED.setLightStatus(token_buffer[1]);
-                    break;
-                // Static colors
-                case t_RED:
-                case t_GREEN:
-                case t_YELLOW:
-                    LED.setRGBColor(
-                        token_buffer[1] == t_RED || token_buffer[1] == t_YELLOW? 255: 0,
-                        token_buffer[1] == t_GREEN || token_buffer[1] == t_YELLOW? 255: 0,
-                        0);
-                    break;
-                case t_BYTE:
-                    if (token_buffer[1] != t_BYTE || token_buffer[3] != t_BYTE ||
-                            token_buffer[5] != t_BYTE)
-                        commandError();
-                    LED.setRGBColor(token_buffer[2], token_buffer[4], token_buffer[6]);
-                    break;
-                default:
-                    commandError();
-            }
-            break;
-        /* ======= */
-        case t_DHT:
-            switch (token_buffer[1]) {
-                case t_EOL:
-                    DHT.printStatus(out);
-                    break;
-                case t_MONITOR:
-                    if (!out.udp_print) {
-                        DHT.toggleMonitor();
-                        press_any_key = true;
-                    }
-                    break;
-                case t_LOG:
-                    switch (token_buffer[2]) {
-                        case t_EOL:
-                            DHT.printLogs();
-                            break;
-                        case t_INFO:
-                            DHT.printLogInfo();
-                            break;
-                        case t_CLEAR:
-                            DHT.clearLog();
-                            break;
-                    }
-                    break;
-            }
-            break;
-        /* ======= */
-        case t_TIME:
-        case t_DATE:
-            RTC.printStatus();
-            break;
-        /* ======= */
-        case t_SET:
-            switch (token_buffer[1]) {
-                case t_TIME:
-                case t_DATE:
-                    if (token_buffer[2] == t_BYTE &&
-                            token_buffer[4] == t_BYTE &&
-                            token_buffer[6] == t_BYTE) {
-                        if (token_buffer[1] == t_TIME)
-                            RTC.setTime(token_buffer[3], token_buffer[5], token_buffer[7]);
-                        if (token_buffer[1] == t_DATE)
-                            RTC.setDate(token_buffer[3], token_buffer[5], token_buffer[7]);
-                    }
-                    else
-                        commandError();
-                    break;
-                case t_BLINK:
-                    // Require number token to proceed
-                    if (token_buffer[2] == t_WORD)
-                        LED.setBlinkRate(word(token_buffer[3], token_buffer[4]));
-                    else if (token_buffer[2] == t_BYTE)
-                        LED.setBlinkRate(token_buffer[3]);
-                    else
-                        commandError();
-                    break;
-                case t_DHT:
-                    if (token_buffer[2] == t_SCALE && token_buffer[3] == t_BYTE)
-                        DHT.setToFahrenheit(token_buffer[3] == 1);
-                    else
-                        commandError();
-                    break;
-            }
-            break;
-        /* ======= */
-        case t_VERSION:
-            out.println(VERSION);
-            break;
-        /* ======= */
-        case t_HELP:
-            out.println(F(
-                "Commands (square brackets denote options):\n\r"
-                "\tLED, DHT, TIME, DATE, VERSION, HELP"
-                "\tLED [on|off|red|green|yellow|blink]\n\r"
-                "\tRGB <0-255> <0-255> <0-255> (RGB values)\n\r"
-                "\tDHT [MONITOR|LOG]\n\r"
-                "\tDHT LOG\n\r\tDHT LOG [INFO|CLEAR]\n\r"
-                "\tSET TIME <HH> <MM> <SS>\n\r"
-                "\tSET DATE <YY> <MM> <DD>\n\r"
-                "\tSET DHT SCALE [0|1] (Celcius or Fahrenheit)\n\r"
-                "\tSET BLINK <number 0-65535>\n\r"
-            ));
-            break;
-        default:
-            commandError();
+    // RGB is an alias of LED
+    if (token_buffer[0] == t_RGB)
+        token_buffer[0] = t_LED;
+    uint8_t keyword;
+    uint16_t args[l_ARGS];
+    bool matched = false;
+    for (uint8_t i = 0; i < sizeof(commands) / sizeof(command_entry) && !matched; i++) {
+        // Cheap first keyword check before copying the row out of flash
+        if (pgm_read_byte(&commands[i].path[0]) != token_buffer[0])
+            continue;
+        command_entry cmd;
+        memcpy_P(&cmd, &commands[i], sizeof(command_entry));
+        if (matchCommand(cmd, &keyword, args)) {
+            cmd.handler(keyword, args);
+            matched = true;
+        }
     }
+    if (!matched)
+        commandError();
     // Save off input if we wish to recall it
     for (uint8_t i=0; i<input_length; i++) {
         last_input[i] = input_buffer[i];
@@ -479,6 +509,178 @@ void parseTokens() {
     last_length = input_length;
 }
 
+// Check the token buffer is exactly the command's keyword path followed by
+//  its arguments. Fills in the last keyword and the argument values.
+bool matchCommand(const command_entry &cmd, uint8_t *keyword, uint16_t *args) {
+    uint8_t t = 0;
+    for (uint8_t i = 0; i < l_PATH && cmd.path[i] != t_EOL; i++) {
+        if (t >= token_length || token_buffer[t] != cmd.path[i])
+            return false;
+        *keyword = token_buffer[t++];
+    }
+    for (uint8_t i = 0; i < l_ARGS && cmd.args[i] != t_EOL; i++) {
+        if (t + 1 < token_length && token_buffer[t] == t_BYTE) {
+            args[i] = token_buffer[t + 1];
+            t += 2;
+        }
+        else if (t + 2 < token_length && token_buffer[t] == t_WORD &&
+                cmd.args[i] == ARG_WORD) {
+            args[i] = word(token_buffer[t + 1], token_buffer[t + 2]);
+            t += 3;
+        }
+        else
+            return false;
+    }
+    // Anything left over makes it a different (unknown) command
+    return t == token_length;
+}
+
+// ============================== //
+// Command handlers, called with the last keyword of the matched path
+void cmdDhtLog(uint8_t keyword, const uint16_t*) {
+    switch (keyword) {
+        case t_LOG:
+            printPaged(logLine);
+            break;
+        case t_INFO:
+            printPaged(logInfoLine);
+            break;
+        case t_CLEAR:
+            DHT.clearLog();
+            break;
+    }
+}
+
+void cmdDhtMonitor(uint8_t, const uint16_t*) {
+    if (!out.udp_print) {
+        DHT.toggleMonitor();
+        press_any_key = true;
+    }
+}
+
+void cmdDhtStatus(uint8_t, const uint16_t*) {
+    DHT.printStatus(out);
+}
+
+void cmdHelp(uint8_t, const uint16_t*) {
+    printPaged(helpLine);
+}
+
+const char help_text[] PROGMEM =
+    "Commands (square brackets denote options):\n\r"
+    "\tLED, DHT, TIME, DATE, TASKS, VERSION, HELP\n\r"
+    "\tLED [on|off|red|green|yellow|blink]\n\r"
+    "\tRGB <0-255> <0-255> <0-255> (RGB values)\n\r"
+    "\tDHT [MONITOR|LOG]\n\r"
+    "\tDHT LOG\n\r\tDHT LOG [INFO|CLEAR]\n\r"
+    "\tSET TIME <HH> <MM> <SS>\n\r"
+    "\tSET DATE <YY> <MM> <DD>\n\r"
+    "\tSET DHT SCALE [0|1] (Celcius or Fahrenheit)\n\r"
+    "\tSET BLINK <number 0-65535>\n\r";
+
+bool helpLine(uint16_t n) {
+    PGM_P p = help_text;
+    // Walk to the start of line n
+    while (n > 0) {
+        char c = pgm_read_byte(p++);
+        if (c == NUL)
+            return false;
+        if (c == '\n')
+            n--;
+    }
+    if (pgm_read_byte(p) == NUL)
+        return false;
+    char c;
+    do {
+        c = pgm_read_byte(p++);
+        if (c == NUL)
+            break;
+        out.print(c);
+    } while (c != '\n');
+    return true;
+}
+
+bool logLine(uint16_t n) {
+    return DHT.printLogLine(n);
+}
+
+bool logInfoLine(uint16_t n) {
+    return DHT.printLogInfoLine(n);
+}
+
+void cmdLedColor(uint8_t color, const uint16_t*) {
+    LED.setRGBColor(
+        color == t_RED || color == t_YELLOW? 255: 0,
+        color == t_GREEN || color == t_YELLOW? 255: 0,
+        0);
+}
+
+void cmdLedLight(uint8_t status, const uint16_t*) {
+    LED.setLightStatus(status);
+}
+
+void cmdLedRGB(uint8_t, const uint16_t *args) {
+    LED.setRGBColor(args[0], args[1], args[2]);
+}
+
+void cmdLedStatus(uint8_t, const uint16_t*) {
+    printPaged(ledLine);
+}
+
+bool ledLine(uint16_t n) {
+    return LED.printStatusLine(n);
+}
+
+void cmdSetBlink(uint8_t, const uint16_t *args) {
+    LED.setBlinkRate(args[0]);
+}
+
+void cmdSetClock(uint8_t keyword, const uint16_t *args) {
+    if (keyword == t_TIME)
+        RTC.setTime(args[0], args[1], args[2]);
+    else
+        RTC.setDate(args[0], args[1], args[2]);
+}
+
+void cmdSetScale(uint8_t, const uint16_t *args) {
+    DHT.setToFahrenheit(args[0] == 1);
+}
+
+void cmdTasks(uint8_t, const uint16_t*) {
+    printPaged(tasksLine);
+}
+
+// The task table then the output, EEPROM, button and RTC counters
+bool tasksLine(uint16_t n) {
+    if (n <= TASKS.count())
+        return TASKS.printStatsLine(out, n);
+    if (n == TASKS.count() + 1) {
+        out.printStats(out);
+        return true;
+    }
+    if (n == TASKS.count() + 2) {
+        EECACHE.printStats(out);
+        return true;
+    }
+    if (n == TASKS.count() + 3) {
+        LCD_UI.printInputStats(out);
+        return true;
+    }
+    if (n == TASKS.count() + 4) {
+        RTC.printStats(out);
+        return true;
+    }
+    return false;
+}
+
+void cmdTime(uint8_t, const uint16_t*) {
+    RTC.printStatus();
+}
+
+void cmdVersion(uint8_t, const uint16_t*) {
+    out.println(VERSION);
+}
+
 // Check for and read user input and save it to the input buffer
 // Returns true if the input buffer is complete
 bool processInput() {
@@ -497,13 +699,13 @@ bool processInput() {
     // Backspace
     else if (input.b == BS_BYTE) {
         if (input_length > 0) {
-            Serial.print(F("\b \b"));
+            out.print(F("\b \b"));
             input_length--;
         }
         return false;
     } // Enter key
     else if (input.b == EOL_BYTE) {
-        Serial.println();
+        out.println();
         input_buffer[input_length] = NUL;
         if (input_length == 0) {
             resetInputBuffer();
@@ -513,11 +715,11 @@ bool processInput() {
     else if (input.special && input.b == UP_ARROW_BYTE) {
         // Erase previous text
         for (uint8_t i=0; i<input_length; i++) {
-            Serial.print(F("\b \b"));
+            out.print(F("\b \b"));
         }
         // Copy andd print from last input
         for (uint8_t i=0; i<last_length; i++) {
-            Serial.print(last_input[i]);
+            out.print(last_input[i]);
             input_buffer[i] = last_input[i];
         }
         input_length = last_length;
@@ -525,7 +727,7 @@ bool processInput() {
     } // Capture regular output bytes
     else if(input_length < l_SENTENCE && capturableByte(input.b)) {
         char byteChar = char(input.b);
-        Serial.print(byteChar);
+        out.print(byteChar);
         input_buffer[input_length++] = tolower(byteChar);
         // Return to stop processing the input further
         return false;
@@ -545,9 +747,9 @@ void resetInputBuffer() {
     input_length = 0;
     input_buffer[0] = NUL;
     if (press_any_key)
-        Serial.println(F("Press any key to continue...\n"));
+        out.println(F("Press any key to continue...\n"));
     else
-        Serial.print(F("\n\r>"));
+        out.print(F("\n\r>"));
 }
 
 // Read a single byte in via Serial. If special keys are read we may
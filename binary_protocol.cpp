@@ -0,0 +1,112 @@
+// binary_protocol.cpp
+#include "binary_protocol.h"
+#include "calendar.h"
+#include "dht_control.h"
+#include "led_control.h"
+#include "network_control.h"
+#include "rtc_control.h"
+#include "token_definitions.h"
+
+#define DEBUG 0
+
+extern dht_control DHT;
+extern led_control LED;
+extern network_control NET;
+extern rtc_control RTC;
+
+static void putWord(uint8_t *p, uint16_t w) {
+    p[0] = lowByte(w);
+    p[1] = highByte(w);
+}
+
+static void putLong(uint8_t *p, uint32_t l) {
+    putWord(p, l);
+    putWord(p + 2, l >> 16);
+}
+
+static void putDateTime(uint8_t *p, const DateTime &ts) {
+    p[0] = ts.Second;
+    p[1] = ts.Minute;
+    p[2] = ts.Hour;
+    p[3] = ts.Dow;
+    p[4] = ts.Day;
+    p[5] = ts.Month;
+    p[6] = ts.Year;
+}
+
+// Fills in the response payload, returns the status
+static uint8_t runOpcode(uint8_t opcode, const uint8_t *args, uint8_t len,
+        uint8_t *payload) {
+    switch (opcode) {
+        case t_DHT:
+            if (len != 0) return BIN_BAD_PAYLOAD;
+            putWord(payload, DHT.getRawTemperature());
+            putWord(payload + 2, DHT.getRawHumidity());
+            payload[4] = DHT.getAlarmState();
+            return BIN_OK;
+        case t_TIME:
+            if (len != 0) return BIN_BAD_PAYLOAD;
+            putDateTime(payload, RTC.readTime());
+            return BIN_OK;
+        case t_INFO:
+            if (len != 0) return BIN_BAD_PAYLOAD;
+            putWord(payload, DHT.getEntriesCount());
+            return BIN_OK;
+        case t_LOG: {
+            if (len != 2)
+                return BIN_BAD_PAYLOAD;
+            uint16_t index = word(args[1], args[0]);
+            if (index >= DHT.getEntriesCount())
+                return BIN_BAD_PAYLOAD;
+            log_entry entry = DHT.getLogEntry(index);
+            putWord(payload, index);
+            putLong(payload + 2, toEpoch(entry.ts));
+            // The log keeps whole units
+            payload[6] = entry.temp / 10;
+            payload[7] = entry.humid / 10;
+            return BIN_OK;
+        }
+        case t_LED:
+            if (len != 1 || args[0] > t_BLINK) return BIN_BAD_PAYLOAD;
+            LED.setLightStatus(args[0]);
+            return BIN_OK;
+        case t_RGB:
+            if (len != 3) return BIN_BAD_PAYLOAD;
+            LED.setRGBColor(args[0], args[1], args[2]);
+            return BIN_OK;
+        default:
+            return BIN_BAD_OPCODE;
+    }
+}
+
+bool isBinaryFrame(const char *packet, uint8_t len) {
+    return len >= BIN_HEADER_SIZE && (uint8_t)packet[0] == BIN_MAGIC;
+}
+
+void handleBinaryFrame(const char *packet, uint8_t len) {
+    const uint8_t *frame = (const uint8_t*)packet;
+    uint8_t response[BIN_RESPONSE_SIZE];
+    for (uint8_t i = 0; i < BIN_RESPONSE_SIZE; i++)
+        response[i] = 0;
+    // Header is echoed so the client can match it to the request
+    response[0] = BIN_MAGIC;
+    response[1] = BIN_VERSION;
+    response[2] = frame[2];
+    response[3] = frame[3];
+    response[4] = frame[4];
+    if (frame[1] != BIN_VERSION)
+        response[5] = BIN_BAD_VERSION;
+    else
+        response[5] = runOpcode(frame[2], frame + BIN_HEADER_SIZE,
+                len - BIN_HEADER_SIZE, response + BIN_HEADER_SIZE + 1);
+    #if DEBUG >= 1
+    Serial.print(F("Binary opcode "));
+    Serial.print(frame[2]);
+    Serial.print(F(" status "));
+    Serial.println(response[5]);
+    #endif
+
+    NET.beginPacket();
+    NET.UDP.write(response, BIN_RESPONSE_SIZE);
+    NET.endPacket();
+}
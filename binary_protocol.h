@@ -0,0 +1,43 @@
+// binary_protocol.h
+/* Compact binary command/telemetry protocol for machine clients. Shares the
+        UDP command port with the text CLI: a frame starts with BIN_MAGIC,
+        which no text command can, so one byte picks the path.
+    Opcodes are the command tokens from token_definitions.h and all
+        multi-byte fields are little-endian.
+
+    Request:  magic | version | opcode | id lo | id hi | payload...
+    Response: magic | version | opcode | id lo | id hi | status | payload[10]
+        Every response is BIN_RESPONSE_SIZE bytes, unused payload is 0.
+
+    Opcode____Request payload________Response payload
+    t_DHT    |                      |temp i16 (0.1C), humid u16 (0.1%), alarm i8
+    t_TIME   |                      |sec, min, hour, dow, day, month, year
+    t_INFO   |                      |entries u16
+    t_LOG    |index u16             |index u16, time u32 (s since 2000),
+             |                      |   temp i8 (C), humid u8
+    t_LED    |status (on/off/blink) |
+    t_RGB    |red, green, blue      |
+*/
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <Arduino.h>
+
+#define BIN_MAGIC 0xB5
+#define BIN_VERSION 2  // 2: log indexes and counts are 16 bit
+#define BIN_HEADER_SIZE 5
+#define BIN_RESPONSE_SIZE 16
+
+// Response status
+#define BIN_OK 0
+#define BIN_BAD_VERSION 1
+#define BIN_BAD_OPCODE 2
+#define BIN_BAD_PAYLOAD 3
+
+// True if the packet is a binary frame rather than a text command
+bool isBinaryFrame(const char*, uint8_t);
+
+// Run the frame and send its fixed size response to the saved destination
+void handleBinaryFrame(const char*, uint8_t);
+
+#endif
@@ -0,0 +1,31 @@
+// calendar.cpp
+#include "calendar.h"
+
+#define DEBUG 0
+
+static_assert(epochDays(0, 1, 1) == 0, "2000-01-01 is day 0");
+static_assert(epochDays(0, 3, 1) == 60, "2000 is a leap year");
+static_assert(epochDays(1, 1, 1) == 366, "2001 starts after 366 days");
+static_assert(epochSeconds(99, 12, 31, 23, 59, 59) == 36525 * SECONDS_PER_DAY - 1,
+        "2099 ends after 100 years of 365.25 days");
+static_assert(daysInMonth(24, 12) == 31 && daysInMonth(24, 11) == 30 &&
+        daysInMonth(24, 2) == 29 && daysInMonth(25, 2) == 28,
+        "month lengths");
+
+DateTime fromEpoch(uint32_t seconds) {
+    DateTime ts;
+    ts.Second = seconds % 60;
+    uint32_t minutes = seconds / 60;
+    ts.Minute = minutes % 60;
+    uint32_t hours = minutes / 60;
+    ts.Hour = hours % 24;
+    uint16_t days = hours / 24;
+    // 2000-01-01 was a Saturday
+    ts.Dow = (days + 6) % 7 + 1;
+    days += CAL_DAYS_TO_2000;
+    uint8_t month = dayMarchMonth(days);
+    ts.Day = dayOfMarchYear(days) - (153U * month + 2) / 5 + 1;
+    ts.Month = month < 10 ? month + 3 : month - 9;
+    ts.Year = dayMarchYear(days) - 4 + (ts.Month <= 2);
+    return ts;
+}
@@ -0,0 +1,80 @@
+// calendar.h
+/* Conversions between the RTC's DateTime and a single count of seconds,
+        which is what logs store and compare. Covers the DS3231's range of
+        2000 through 2099, where every fourth year is a leap year.
+    Everything but fromEpoch() is constexpr and without loops or tables:
+        years are counted from March, so the leap day is the last day of
+        its year and the days before each month follow (153 * m + 2) / 5.
+        The March based years start in 1996 to keep them positive. */
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <Arduino.h>
+#include <DS3231_Simple.h>
+
+#define SECONDS_PER_DAY 86400UL
+
+// Days from 1996-03-01 to 2000-01-01
+#define CAL_DAYS_TO_2000 1401
+
+// Years since March 1996 of a date, and its month counted from March
+constexpr uint8_t marchYear(uint8_t year, uint8_t month) {
+    return year + 4 - (month <= 2);
+}
+constexpr uint8_t marchMonth(uint8_t month) {
+    return (month + 9) % 12;
+}
+
+constexpr uint8_t daysInMonth(uint8_t year, uint8_t month) {
+    return month == 2 ? 28 + (year % 4 == 0) :
+            30 + ((month + (month >> 3)) & 1);
+}
+
+// A year 0..99, month 1..12 and day that exists in it
+constexpr bool validDate(uint8_t year, uint8_t month, uint8_t day) {
+    return year <= 99 && month >= 1 && month <= 12 && day >= 1 &&
+            day <= daysInMonth(year, month);
+}
+
+constexpr bool validTime(uint8_t hour, uint8_t minute, uint8_t second) {
+    return hour < 24 && minute < 60 && second < 60;
+}
+
+// Days since 2000-01-01
+constexpr uint16_t epochDays(uint8_t year, uint8_t month, uint8_t day) {
+    return 365U * marchYear(year, month) + marchYear(year, month) / 4 +
+            (153U * marchMonth(month) + 2) / 5 + day - 1 - CAL_DAYS_TO_2000;
+}
+
+// Seconds since 2000-01-01 00:00:00
+constexpr uint32_t epochSeconds(uint8_t year, uint8_t month, uint8_t day,
+        uint8_t hour, uint8_t minute, uint8_t second) {
+    return epochDays(year, month, day) * SECONDS_PER_DAY +
+            (hour * 60U + minute) * 60UL + second;
+}
+
+constexpr uint32_t toEpoch(const DateTime &ts) {
+    return epochSeconds(ts.Year, ts.Month, ts.Day, ts.Hour, ts.Minute,
+            ts.Second);
+}
+
+// Seconds from a to b, negative if b is earlier
+constexpr int32_t secondsBetween(const DateTime &a, const DateTime &b) {
+    return (int32_t)(toEpoch(b) - toEpoch(a));
+}
+
+// The parts of a day count, days since 1996-03-01 going in
+constexpr uint8_t dayMarchYear(uint16_t days) {
+    return (4UL * days + 3) / 1461;
+}
+constexpr uint16_t dayOfMarchYear(uint16_t days) {
+    return days - (365U * dayMarchYear(days) + dayMarchYear(days) / 4);
+}
+constexpr uint8_t dayMarchMonth(uint16_t days) {
+    return (5U * dayOfMarchYear(days) + 2) / 153;
+}
+
+// Back to a DateTime, day of week included (Sunday is 1)
+DateTime fromEpoch(uint32_t);
+
+#endif
@@ -0,0 +1,142 @@
+// config_store.cpp
+#include "config_store.h"
+#include "dht_log.h"
+
+#define DEBUG 0
+
+// Old fixed layout, AVR sizes
+#define LEGACY_DEST_IP 247
+#define LEGACY_DEST_PORT 253
+#define LEGACY_LOCAL_IP 255
+#define LEGACY_SUBNET 261
+#define LEGACY_GATEWAY 267
+#define LEGACY_ALARMS 273
+#define LEGACY_IP_BYTES 2   // Skips the vtable pointer
+#define LEGACY_END 280
+
+// Version 1, before button_levels
+#define V1_CRC 30
+
+static_assert(sizeof(config_data) == 36, "config_data must stay packed");
+
+extern eeprom_cache EECACHE;
+
+const config_data config_defaults PROGMEM = {
+    CONFIG_MAGIC, CONFIG_VERSION,
+    {192, 168, 1, 1}, 8888,
+    {192, 168, 1, 177},
+    {255, 255, 255, 0},
+    {192, 168, 1, 1},
+    {60, 70, 80, 90},
+    LOG_FORMAT,
+    {185, 37, 82, 2, 125},  // The card's nominal 740, 150, 330, 10, 500
+    0
+};
+
+uint16_t config_store::crc(const config_data &d, uint8_t length) {
+    const uint8_t *p = (const uint8_t*)&d;
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)p[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Blank cells read 255.255.255.255, and 0.0.0.0 is no use either
+static bool legacyIP(uint16_t at, uint8_t *ip) {
+    uint8_t ones = 0xFF, zeros = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t b = EECACHE.read(at + LEGACY_IP_BYTES + i);
+        ones &= b;
+        zeros |= b;
+    }
+    if (ones == 0xFF || zeros == 0)
+        return false;
+    for (uint8_t i = 0; i < 4; i++)
+        ip[i] = EECACHE.read(at + LEGACY_IP_BYTES + i);
+    return true;
+}
+
+void config_store::migrate() {
+    bool found = legacyIP(LEGACY_DEST_IP, data.dest_ip);
+    found |= legacyIP(LEGACY_LOCAL_IP, data.local_ip);
+    found |= legacyIP(LEGACY_SUBNET, data.subnet);
+    found |= legacyIP(LEGACY_GATEWAY, data.gateway);
+    uint16_t port;
+    EECACHE.get(LEGACY_DEST_PORT, port);
+    if (port != 0 && port != 0xFFFF) {
+        data.dest_port = port;
+        found = true;
+    }
+    // Gates only make sense as a set, rising and in the sensor's range
+    int16_t gates[4];
+    EECACHE.get(LEGACY_ALARMS, gates);
+    bool sane = true;
+    for (uint8_t i = 0; i < 4; i++)
+        sane &= gates[i] >= -40 && gates[i] <= 176 &&
+                (i == 0 || gates[i] > gates[i-1]);
+    if (sane) {
+        for (uint8_t i = 0; i < 4; i++)
+            data.alarm_gates[i] = gates[i];
+        found = true;
+    }
+    if (found)
+        source = MIGRATED;
+}
+
+bool config_store::upgrade() {
+    if (data.magic != CONFIG_MAGIC || data.version != 1)
+        return false;
+    const uint8_t *p = (const uint8_t*)&data;
+    if (word(p[V1_CRC + 1], p[V1_CRC]) != crc(data, V1_CRC))
+        return false;
+    // Everything before the reserved byte kept its place
+    config_data defaults;
+    memcpy_P(&defaults, &config_defaults, sizeof(defaults));
+    memcpy(data.button_levels, defaults.button_levels,
+            sizeof(data.button_levels));
+    data.version = CONFIG_VERSION;
+    return true;
+}
+
+void config_store::load(uint16_t at) {
+    address = at;
+    EECACHE.get(address, data);
+    if (data.magic == CONFIG_MAGIC && data.version == CONFIG_VERSION &&
+            data.crc == crc(data, offsetof(config_data, crc))) {
+        source = LOADED;
+        return;
+    }
+    if (upgrade()) {
+        source = UPGRADED;
+        save();
+        return;
+    }
+    memcpy_P(&data, &config_defaults, sizeof(data));
+    source = DEFAULTS;
+    // Without a config nothing says what format the log region is in, be
+    //  it older logs or garbage, so it gets cleared
+    data.log_format = 0;
+    migrate();
+    if (source == MIGRATED) {
+        save();
+        EECACHE.flush();
+        // Erased once the config is down, so a damaged config later can't
+        //  bring them back over newer settings
+        for (uint16_t i = LEGACY_DEST_IP; i <= LEGACY_END; i++)
+            EECACHE.write(i, 0xFF);
+    }
+    else
+        save();
+    #if DEBUG >= 1
+    Serial.print(F("Config rebuilt from "));
+    Serial.println(source == MIGRATED ? F("old layout") : F("defaults"));
+    #endif
+}
+
+void config_store::save() {
+    data.crc = crc(data, offsetof(config_data, crc));
+    EECACHE.put(address, data);
+}
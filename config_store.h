@@ -0,0 +1,84 @@
+// config_store.h
+/* Every saved setting in one packed, versioned, CRC-checked block, read
+        once at boot. A block that doesn't check out is replaced by the
+        settings found in the old fixed layout if they look sane, and by
+        defaults otherwise.
+    Config layout (sizeof(config_data), fields are naturally aligned so
+        the AVR and the host agree on it):
+        magic ........ 1  CONFIG_MAGIC
+        version ...... 1  CONFIG_VERSION
+        dest_ip ...... 4  Where UDP replies and alarms go
+        dest_port .... 2
+        local_ip ..... 4
+        subnet ....... 4
+        gateway ...... 4
+        alarm_gates .. 8  Four int16, degrees F, see dht_control
+        log_format ... 1  LOG_FORMAT of the log region, a mismatch clears it
+        button_levels  5  ADC reading / 4 of each button, OK, Up, Down,
+                          Left then Right, see five_btn
+        crc .......... 2  CRC-16/CCITT of everything before it
+    Version 1 blocks are upgraded in place, they had a reserved byte where
+        button_levels starts and the CRC at 30.
+    The old layout (before CONFIG_VERSION 1) stored IPAddress objects
+        as-is, which on the AVR is a 2 byte vtable pointer and then the
+        4 address bytes:
+        247 dest_ip, 253 dest_port, 255 local_ip, 261 subnet, 267 gateway,
+        273 four int alarm gates through 280 */
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include "eeprom_cache.h"
+
+#define CONFIG_MAGIC 0xC5
+#define CONFIG_VERSION 2
+#define CONFIG_BUTTONS 5
+
+struct config_data {
+    uint8_t magic;
+    uint8_t version;
+    uint8_t dest_ip[4];
+    uint16_t dest_port;
+    uint8_t local_ip[4];
+    uint8_t subnet[4];
+    uint8_t gateway[4];
+    int16_t alarm_gates[4];
+    uint8_t log_format;
+    uint8_t button_levels[CONFIG_BUTTONS];
+    uint16_t crc;
+};
+
+// Factory settings, in flash
+extern const config_data config_defaults;
+
+class config_store
+{
+    private:
+        uint16_t address;
+
+        // CRC of the block up to the given length
+        uint16_t crc(const config_data&, uint8_t);
+        // Bring a valid older block up to CONFIG_VERSION, false if it isn't
+        bool upgrade();
+        // Fill in whatever the old layout holds that looks sane
+        void migrate();
+    public:
+        // Where the settings came from at boot
+        static const byte LOADED = 0;
+        static const byte MIGRATED = 1;
+        static const byte DEFAULTS = 2;
+        static const byte UPGRADED = 3;
+
+        config_data data;
+        byte source = DEFAULTS;
+
+        // Read the block at the EEPROM address, upgrading an older version
+        //  or else falling back to the old layout and then defaults, which
+        //  are saved straight away
+        void load(uint16_t);
+
+        // Write data back, only the bytes that changed reach the EEPROM
+        void save();
+};
+
+#endif
@@ -0,0 +1,89 @@
+// dht22_reader.cpp
+#include "dht22_reader.h"
+
+#define DEBUG 0
+
+#define START_PULSE_MS 2   // Sensor wants at least 1ms low, millis() ticks 1ms
+#define FRAME_MS 6         // 160us response + 40 bits of at most 120us each
+#define FRAME_EDGES 42     // Response, first bit start, then one per bit
+#define ONE_BIT_US 100     // Falling edge to falling edge: 0 is ~78us, 1 is ~120us
+
+// Shared with the ISR
+static volatile uint8_t isr_pin;
+static volatile uint8_t edge_count;
+static volatile uint16_t last_edge;
+static volatile byte frame[5];
+
+// Every falling edge ends a bit. The gap since the previous one is
+//  50us low plus either ~27us (0) or ~70us (1) high.
+ISR(PCINT0_vect) {
+    if (digitalRead(isr_pin) == HIGH)
+        return;
+    uint16_t now = micros();
+    uint16_t period = now - last_edge;
+    last_edge = now;
+    uint8_t e = edge_count;
+    if (e >= FRAME_EDGES)
+        return;
+    // First two edges are the sensor's response and the first bit's start
+    if (e >= 2 && period > ONE_BIT_US) {
+        uint8_t bit = e - 2;
+        frame[bit >> 3] |= 0x80 >> (bit & 7);
+    }
+    edge_count = e + 1;
+}
+
+void dht22_reader::begin(uint8_t p) {
+    pin = p;
+    isr_pin = p;
+    pinMode(pin, INPUT_PULLUP);
+}
+
+uint8_t dht22_reader::start() {
+    if (state != IDLE)
+        return 0;
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    state = START;
+    return START_PULSE_MS;
+}
+
+uint8_t dht22_reader::step() {
+    switch (state) {
+        case START:
+            // Arm the capture then release the line for the sensor to answer
+            edge_count = 0;
+            for (uint8_t i = 0; i < 5; i++)
+                frame[i] = 0;
+            *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+            *digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+            pinMode(pin, INPUT_PULLUP);
+            state = CAPTURE;
+            return FRAME_MS;
+        case CAPTURE:
+            *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
+            state = IDLE;
+            #if DEBUG >= 1
+            Serial.print(F("DHT22 edges: "));
+            Serial.println(edge_count);
+            #endif
+            if (edge_count < FRAME_EDGES) {
+                last_error = ERR_TIMEOUT;
+                return 0;
+            }
+            if ((byte)(frame[0] + frame[1] + frame[2] + frame[3]) != frame[4]) {
+                last_error = ERR_CHECKSUM;
+                return 0;
+            }
+            humidity = word(frame[0], frame[1]);
+            // Temperature is sign and magnitude, not two's complement
+            temperature = word(frame[2] & 0x7F, frame[3]);
+            if (frame[2] & 0x80)
+                temperature = -temperature;
+            last_error = ERR_NONE;
+            return 0;
+        default:
+            // No frame in progress
+            return 0;
+    }
+}
@@ -0,0 +1,47 @@
+// dht22_reader.h
+/* Non-blocking DHT22 reader. The start pulse is timed by the scheduler and
+        the 40 bit frame is captured by a pin change interrupt, so nothing
+        ever busy-waits on the sensor.
+    Only PCINT0_vect is claimed, so the pin has to be on PORTB (8-13). */
+#ifndef DHT22_READER_H
+#define DHT22_READER_H
+
+#include <Arduino.h>
+
+class dht22_reader
+{
+    private:
+        uint8_t pin;
+        byte state = IDLE;
+        byte last_error = ERR_NONE;
+        int16_t temperature = 0, humidity = 0;
+
+        static const byte IDLE = 0;
+        static const byte START = 1;
+        static const byte CAPTURE = 2;
+    public:
+        static const byte ERR_NONE = 0;
+        static const byte ERR_BUSY = 1;     // A frame is already in progress
+        static const byte ERR_TIMEOUT = 2;  // Fewer than 40 bits came back
+        static const byte ERR_CHECKSUM = 3;
+
+        // Set the pin the sensor is on and release the line
+        void begin(uint8_t);
+
+        // Pull the line low to request a frame
+        //  Returns ms until step() should be called, 0 if already busy
+        uint8_t start();
+
+        // Advance the frame. Returns ms until it should be called again
+        //  or 0 once the frame is finished and error() is valid
+        uint8_t step();
+
+        // Result of the last finished frame
+        byte error() { return last_error; }
+
+        // Last good reading in tenths of a degree C and tenths of %RH
+        int16_t getTemperature() { return temperature; }
+        int16_t getHumidity() { return humidity; }
+};
+
+#endif
@@ -11,34 +11,41 @@
 #define DHT_PIN 8
 #define READ_DELAY 5 // in seconds
 #define LOG_DELAY 15 // in minutes
-#define MAX_LOG_BYTES 247 // Limited by our byte sized index
-#define MAX_LOG_ENTRIES 27 // (247 - 4) / (9, size of entry)
+#define LOG_SLACK 60 // seconds a log may run ahead of its boundary
 #define RGB_ALARM_LIGHT 2
-// EEPROM logs use byte 0 through 246
+#define ALARM_BLINK_MS 1000 // Minor alarms
+#define ALARM_CYCLE_MS 1200 // Major alarms, through the whole palette
+// EEPROM logs use byte 0 through 246, LOG_BLOCKS of LOG_BLOCK_SIZE
 #define EEPROM_LOGS 0
-// Saved alarm data fills bytes 273 through 279
-#define EEPROM_ALARMS 273
+// Log statistics summary, LOG_SUMMARY_SIZE bytes
+#define EEPROM_LOG_STATS 281
 
 // Out is used for any outward output in response to a function call
 // and will ouput to serial or udp depending on Output's setting
 extern Output out;
 // Pull the LED control from main.cpp to toggle our alarm light
 extern led_control LED;
+extern task_scheduler TASKS;
+extern config_store CONFIG;
 
 void dht_control::setup(rtc_control *ptr) {
     rtc_ptr = ptr;
-    dht22 = SimpleDHT22(DHT_PIN);
-    EEPROM.get(EEPROM_LOGS, log_index);
-    EEPROM.get(EEPROM_LOGS + sizeof(int), log_entries);
+    dht22.begin(DHT_PIN);
+    logs.begin(EEPROM_LOGS, EEPROM_LOG_STATS, 60 * LOG_DELAY);
+    // Anything in another format is unreadable, start over
+    if (CONFIG.data.log_format != LOG_FORMAT) {
+        logs.clear();
+        CONFIG.data.log_format = LOG_FORMAT;
+        CONFIG.save();
+    }
     alarm_state = 0;
     LED.setRGBColor(RGB_ALARM_LIGHT, 0, 50, 0);
     #if DEBUG > 1
     //clearLog();
     #endif
-    // Call loop immedietly to get a reading
-    // Read EEPROM for alarm gates
+    // Saved alarm gates
     for (int i = 0; i < 4; i ++) {
-        EEPROM.get(EEPROM_ALARMS + i * sizeof(int), alarm_gates[i]);
+        alarm_gates[i] = CONFIG.data.alarm_gates[i];
         #if DEBUG >= 1
         Serial.print("Alarm Gate ");
         Serial.print(i);
@@ -46,26 +53,59 @@ void dht_control::setup(rtc_control *ptr) {
         Serial.println(alarm_gates[i]);
         #endif
     }
-    loop();
+    // Get a reading immedietly, the first log goes out shortly after it
+    TASKS.add(F("dht"), readTask, this, 1000UL * READ_DELAY);
+    step_task = TASKS.add(F("dhtstep"), stepTask, this, 0);
+    TASKS.stop(step_task);
+    log_task = TASKS.add(F("dhtlog"), logTask, this, 60000UL * LOG_DELAY,
+            1000, 40000);
+}
+
+void dht_control::readTask(void *ctx) {
+    dht_control *self = (dht_control*)ctx;
+    uint8_t wait = self->dht22.start();
+    if (wait)
+        TASKS.wake(self->step_task, wait);
+}
+
+void dht_control::stepTask(void *ctx) {
+    dht_control *self = (dht_control*)ctx;
+    uint8_t wait = self->dht22.step();
+    if (wait)
+        TASKS.wake(self->step_task, wait);
+    else
+        self->processReading();
 }
 
-void dht_control::loop() {
-    // Read delay stores the modulo result on millis
-    // New read is done if this number loops back to 0
-    static unsigned int read_delay = 1000*READ_DELAY;
-    unsigned int read_check = millis() % (1000*READ_DELAY);
-    if (read_check > read_delay) return;
-    read_delay = read_check;
+void dht_control::logTask(void *ctx) {
+    dht_control *self = (dht_control*)ctx;
+    // Nothing worth logging until the sensor has answered once
+    if (!self->has_reading)
+        return;
+    #if DEBUG >= 2
+        Serial.println(F("DHT log being written."));
+    #endif
+    self->logReading();
+    // Next on the boundary, so intervals stay whole periods however far
+    //  millis() drifts from the RTC. Just short of one counts as on it.
+    uint16_t period = 60 * LOG_DELAY;
+    uint16_t left = period - self->rtc_ptr->now() % period;
+    if (left < LOG_SLACK)
+        left += period;
+    TASKS.wake(self->log_task, left * 1000UL);
+}
 
-    // Read in data
-    int err = SimpleDHTErrSuccess;
-    if ((err = dht22.read2(&temperature, &humidity, NULL)) != SimpleDHTErrSuccess) {
+bool dht_control::processReading() {
+    if (dht22.error() != dht22_reader::ERR_NONE) {
         if (monitor) {
-            Serial.print(F("DHT read failed, err=")); Serial.print(SimpleDHTErrCode(err));
-            Serial.print(F(",")); Serial.println(SimpleDHTErrDuration(err));
+            out.print(F("DHT read failed, err="));
+            out.println(dht22.error());
         }
-        return;
+        return false;
     }
+    temperature = dht22.getTemperature();
+    humidity = dht22.getHumidity();
+    has_reading = true;
     // If alarm state was changed, broadcast it to the udp out
     if (checkForAlarm()) {
         #if DEBUG >= 1
@@ -76,22 +116,12 @@ void dht_control::loop() {
     if (monitor) {
         printReading(out, temperature, humidity);
     }
-
-    // Check for if we wish to log our reading
-    // Assuming it is a big enough number that we
-    // Shouldn't bother using the smaller number type above
-    static unsigned long log_delay = 0;
-    if (millis() > log_delay) {
-        log_delay += 60000 * LOG_DELAY; // 1000ms * 60s * delay in minutes
-        #if DEBUG >= 2
-            Serial.println(F("DHT log being written."));
-        #endif
-        logReading();
-    }
+    return true;
 }
 
 bool dht_control::checkForAlarm() {
-    int temp = toFahrenheit(temperature);
+    // Whole degrees as displayed, the gates are whole degrees
+    int temp = roundTenths(toFahrenheit(temperature));
     int8_t state_check;
     // First check what the current state is
     if (temp <= alarm_gates[0])
@@ -131,8 +161,13 @@ bool dht_control::checkForAlarm() {
                 LED.setRGBColor(RGB_ALARM_LIGHT, 100, 0, 0);
                 break;
         }
-        if (alarm_state != 0)
-            LED.setLightStatus(RGB_ALARM_LIGHT, t_BLINK);
+        // Its own rates, whatever the user light is doing
+        if (alarm_state == 2)
+            LED.setCycle(RGB_ALARM_LIGHT, LED_PALETTE_HOT, ALARM_CYCLE_MS);
+        else if (alarm_state == -2)
+            LED.setCycle(RGB_ALARM_LIGHT, LED_PALETTE_COLD, ALARM_CYCLE_MS);
+        else if (alarm_state != 0)
+            LED.setEffect(RGB_ALARM_LIGHT, t_BLINK, ALARM_BLINK_MS, 0);
         else
             LED.setLightStatus(RGB_ALARM_LIGHT, t_ON);
         out.print(F(" "));
@@ -144,39 +179,10 @@ bool dht_control::checkForAlarm() {
 }
 
 void dht_control::clearLog() {
-    for (unsigned int i = 0; i < MAX_LOG_BYTES; i++)
-        EEPROM.write(EEPROM_LOGS + i, 0);
-    log_index = 2 * sizeof(int);
-    log_entries = 0;
-    // First couple bytes are the index and entries values
-    EEPROM.write(EEPROM_LOGS, log_index);
-    EEPROM.write(EEPROM_LOGS + sizeof(int), log_entries);
+    logs.clear();
     out.println("DHT Log cleared.");
 }
 
-log_entry dht_control::getLogEntry(uint8_t i) {
-    uint16_t memIndex;
-    log_entry entry;
-    // What is the current starting point of our logs?
-    if (log_entries == MAX_LOG_ENTRIES)
-        memIndex = log_index;
-    else
-        memIndex = 2 * sizeof(int);
-    // Move along the memory i number of spots
-    memIndex += (i * log_size);
-    // If we are past max then start from the begining again
-    if (memIndex + log_size > MAX_LOG_BYTES) {
-        // Number of entries past the max we are at
-        uint8_t overflow_i = (memIndex - MAX_LOG_BYTES) / log_size;
-        memIndex = 2 * sizeof(int) + overflow_i * log_size;
-    }
-    #if DEBUG >= 1
-    Serial.println(memIndex);
-    #endif
-    EEPROM.get(EEPROM_LOGS + memIndex, entry);
-    return entry;
-}
-
 // Enter the current readings into the EEPROM log
 void dht_control::logReading() {
     // Build the log
@@ -184,48 +190,62 @@ void dht_control::logReading() {
     newLog.ts = rtc_ptr->readTime();
     newLog.temp = temperature;
     newLog.humid = humidity;
-    // Only change entries if we haven't hit max logs
-    if (log_entries < MAX_LOG_ENTRIES) {
-        log_entries++;
-        EEPROM.write(EEPROM_LOGS + sizeof(int), log_entries);
-    }
-    #if DEBUG >= 3
-    Serial.print(F("Current-entries max-entries log-index: "));
-    Serial.print(log_entries); Serial.print(F(" "));
-    Serial.print(MAX_LOG_ENTRIES); Serial.print(F(" "));
-    Serial.print(log_index); Serial.println(F(" "));
-    #endif
-    // Write the log to memory
-    EEPROM.put(EEPROM_LOGS + log_index, newLog);
-    // Get the new index and write it to 0
-    log_index += log_size;
-    // Check if we need to start overwriting old logs
-    if (log_index + log_size > MAX_LOG_BYTES) {
-        log_index = 2 * sizeof(int);
-    }
-    EEPROM.write(EEPROM_LOGS, log_index);
+    logs.append(newLog);
+}
+
+// Mean of whole values in tenths, rounded half away from zero
+static int16_t meanTenths(int32_t sum, uint32_t count) {
+    int32_t half = count / 2;
+    return (sum * 10 + (sum < 0 ? -half : half)) / (int32_t)count;
 }
 
 // Print info and stats about the log 
 void dht_control::printLogInfo() {
-    out.print(log_entries);
-    out.print(F(" entries stored in the log. Next memory address is "));
-    out.println(log_index);
-    if (log_entries == 0) return;
-    log_entry entry;
-    byte max_temp = 0, min_temp = 255, ct = 0;
-    for (int i = 2 * sizeof(int); ct < log_entries; i+= log_size) {
-        EEPROM.get(EEPROM_LOGS + i, entry);
-        max_temp = max(max_temp, entry.temp);
-        min_temp = min(min_temp, entry.temp);
-        ct++;
+    for (uint16_t n = 0; printLogInfoLine(n); n++)
+        ;
+}
+
+bool dht_control::printLogInfoLine(uint16_t n) {
+    const log_stats &stats = logs.stats();
+    if (n > 0 && stats.count == 0)
+        return false;
+    switch (n) {
+        case 0:
+            out.print(logs.count());
+            out.println(F(" entries stored in the log."));
+            break;
+        case 1:
+            out.print(stats.count);
+            out.println(F(" readings since the log was cleared."));
+            break;
+        case 2:
+            out.print(F("Max Temperature: "));
+            printTemperature(out, stats.temp_max * 10);
+            out.print(F("\n"));
+            break;
+        case 3:
+            out.print(F("Min Temperature: "));
+            printTemperature(out, stats.temp_min * 10);
+            out.print(F("\n"));
+            break;
+        case 4:
+            out.print(F("Mean Temperature: "));
+            printTemperature(out, meanTenths(stats.temp_sum, stats.count));
+            out.print(F("\n"));
+            break;
+        case 5:
+            out.print(F("Humidity: "));
+            out.print(stats.humid_min);
+            out.print(F("-"));
+            out.print(stats.humid_max);
+            out.print(F("%, mean "));
+            printTenths(out, meanTenths(stats.humid_sum, stats.count));
+            out.println(F("%"));
+            break;
+        default:
+            return false;
     }
-    out.print(F("Max Temperature: "));
-    printTemperature(out, max_temp);
-    out.print(F("\n"));
-    out.print(F("Min Temperature: "));
-    printTemperature(out, min_temp);
-    out.print(F("\n"));
+    return true;
 }
 
 // Print the entirety of the logs
@@ -233,38 +253,32 @@ void dht_control::printLogs() {
     #if DEBUG >= 1
     logReading();
     #endif
-    if (log_entries == 0) {
-        Serial.println(F("No logs."));
-        return;
-    }
-    #if DEBUG >= 1
-    Serial.println(F("Log-index log-size log-entries max_entries: "));
-    Serial.print(log_index); Serial.print(F(" "));
-    Serial.print(log_size); Serial.print(F(" "));
-    Serial.println(log_entries);
-    #endif
-    out.println(F("Date\tTime\tTemp, Humidity"));
-    // Calculate index of the oldest entry
-    uint8_t mem_index = 2 * sizeof(int);
-    log_entry entry;
-    // If this number of entries is at max our oldest entry
-    //  will actually be the next one we plan to overwrite
-    //  at log_index
-    if (log_entries == MAX_LOG_ENTRIES) {
-        mem_index = log_index;
-    }
-    for (unsigned int ct = 0; ct < log_entries; ct++) {
-        entry = getLogEntry(ct);
-        rtc_ptr->print(entry.ts);
-        out.print(F("\t"));
-        printReading(out, entry.temp,entry.humid);
+    for (uint16_t n = 0; printLogLine(n); n++)
+        ;
+}
+
+bool dht_control::printLogLine(uint16_t n) {
+    if (n == 0) {
+        if (logs.count() == 0)
+            out.println(F("No logs."));
+        else
+            out.println(F("Date\tTime\tTemp, Humidity"));
+        return true;
     }
+    if (n > logs.count())
+        return false;
+    // Lines come in order, so each is decoded straight on from the last
+    log_entry entry = logs.get(n - 1);
+    rtc_ptr->print(entry.ts);
+    out.print(F("\t"));
+    printReading(out, entry.temp, entry.humid);
+    return true;
 }
 
-void dht_control::printReading(Print &Printer, float temp, float humid) {
+void dht_control::printReading(Print &Printer, int16_t temp, int16_t humid) {
     printTemperature(Printer, temp);
     Printer.print(F(", "));
-    Printer.print((int)humid);
+    printTenths(Printer, humid);
     Printer.println(F("%RH"));
 }
 
@@ -275,37 +289,48 @@ void dht_control::printStatus(Print &Printer) {
     Printer.println(isFahrenheit ? F("Fahrenheit"): F("Celcius"));
 }
 
-void dht_control::printTemperature(Print &Printer, float t) {
+void dht_control::printTemperature(Print &Printer, int16_t t) {
     if (isFahrenheit) {
-        Printer.print((int)toFahrenheit(t));
+        printTenths(Printer, toFahrenheit(t));
         Printer.print(F("°F"));
     }
     else {
-        Printer.print((int)t);
+        printTenths(Printer, t);
         Printer.print(F("°C"));
     }
 }
 
+void dht_control::printTenths(Print &Printer, int16_t t) {
+    if (t < 0) {
+        Printer.print('-');
+        t = -t;
+    }
+    Printer.print(t / 10);
+    Printer.print('.');
+    Printer.print(t % 10);
+}
+
 void dht_control::setAlarmGates(int majL, int minL, int minH, int majH) {
     alarm_gates[0] = majL;
     alarm_gates[1] = minL;
     alarm_gates[2] = minH;
     alarm_gates[3] = majH;
-    for(int i = 0; i < 4; i++) {
-        EEPROM.put(EEPROM_ALARMS + i*sizeof(int), alarm_gates[i]);
-    }
+    for(int i = 0; i < 4; i++)
+        CONFIG.data.alarm_gates[i] = alarm_gates[i];
+    CONFIG.save();
 }
 
 void dht_control::setToFahrenheit(bool f) {
     isFahrenheit = f;
 }
 
-int dht_control::toFahrenheit(float celcius) {
-    return (celcius * 1.8) + 32;
+int16_t dht_control::toFahrenheit(int16_t celcius) {
+    // * 1.8 rounded, the DHT22's -40..80C keeps it well inside 16 bits
+    return (celcius * 9 + (celcius < 0 ? -2 : 2)) / 5 + 320;
 }
 
 void dht_control::toggleMonitor() {
     monitor = !monitor;
     if (monitor)
-        Serial.println(F("DHT readings will now be printed."));
+        out.println(F("DHT readings will now be printed."));
 }
\ No newline at end of file
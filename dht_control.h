@@ -1,54 +1,50 @@
 // dht_control.h
-/* Class to control the DHT sensor */
+/* Class to control the DHT sensor
+    Readings stay in the sensor's tenths of a degree C and of %RH all the
+        way through, as int16_t, so nothing needs floating point. */
 #ifndef DHT_H
 #define DHT_H
 
 #include <Arduino.h>
-#include <SimpleDHT.h>
-#include <EEPROM.h>
+#include "config_store.h"
+#include "dht22_reader.h"
+#include "dht_log.h"
 #include "output.h"
 #include "rtc_control.h"
+#include "scheduler.h"
 #include "token_definitions.h"
 
-struct log_entry {
-    DateTime ts;
-    char temp;
-    byte humid;
-    /* Might be better to not bother storing year?
-            We can only store max of 113 entries with this size entry (9)
-        which comes to 28.5 hours of logs if saving every 15 min.
-            Assuming year is an extra byte we could have a max of
-        31.8 hours. If we dropped day of week, 36.4 hours. And we if dropped the
-        entire date portion and instead just recorded day of week, 42.5 hours.
-        And if only stored time we could get 51 hours.
-            All of these numbers are assuming we use the entire 1024 memory by doing
-        the following:
-            If we changed the num_entries byte to be a bit for whether we
-        are overwriting older values. And then used the two bytes (minus that bit)
-        to store a higher index without having to use another byte.
-    */
-};
-
 class dht_control
 {
     private:
-        SimpleDHT22 dht22;
-        static const uint16_t log_size = sizeof(log_entry);
-        unsigned int log_index = 0, log_entries = 0;
+        dht22_reader dht22;
+        uint8_t step_task = TASK_NONE;
+        uint8_t log_task = TASK_NONE;
+        bool has_reading = false;
+        dht_log logs;
         signed int alarm_state:3;
         rtc_control *rtc_ptr;
         bool isFahrenheit = true;
+
+        // Scheduled every READ_DELAY and LOG_DELAY respectively, logs are
+        //  kept on the clock's LOG_DELAY boundaries after the first
+        static void readTask(void*);
+        static void logTask(void*);
+        // One-shot, woken for each step of a frame the reader asks for
+        static void stepTask(void*);
     public:
         signed int alarm_gates[4];
         bool monitor = false;
-        float temperature = 0, humidity = 0;
+        // Last good reading, tenths of a degree C and of %RH
+        int16_t temperature = 0, humidity = 0;
 
-        // Arduino setup function
+        // Arduino setup function, registers the read, step and log tasks
+        //  with the first read starting immediately
         void setup(rtc_control*);
 
-        // Looping portion, controls reads and logging calls and
-        //  makes periodic calls to check for alarm.
-        void loop();
+        // Take a finished frame from the reader, check for alarm and print
+        //  if monitoring. Returns false if the read failed
+        bool processReading();
 
         /* Checks currently stored data against "alarm conditions" and
             stores result in alarm_state. Set alarm LED's color and send
@@ -65,29 +61,51 @@ class dht_control
         // Erases the portion of memory the controller uses
         void clearLog();
 
-        // Retrieve a specific log object
-        log_entry getLogEntry(uint8_t);
+        // Retrieve a specific log object, oldest first
+        //  Reading them in order decodes each one once
+        log_entry getLogEntry(uint16_t i) { return logs.get(i); }
 
         // Get number of log entries
-        uint8_t getEntriesCount() { return log_entries; }
+        uint16_t getEntriesCount() { return logs.count(); }
+
+        // Running statistics since the log was last cleared
+        const log_stats &getLogStats() { return logs.stats(); }
+
+        // Current alarm state, -2 through +2 as in checkForAlarm()
+        int8_t getAlarmState() { return alarm_state; }
+
+        // Last good reading in tenths of a degree C and tenths of %RH
+        int16_t getRawTemperature() { return dht22.getTemperature(); }
+        int16_t getRawHumidity() { return dht22.getHumidity(); }
 
         // Write current reading to the EEPROM
         void logReading();
 
-        // Prints information about what is written to EEPROM
+        // Prints the log's size and its statistics since the last clear,
+        //  none of which reads the log itself
         void printLogInfo();
 
+        // Print line n of the log info, returns false once past the last
+        bool printLogInfoLine(uint16_t);
+
+        // Print line n of the log listing, the header then one per entry
+        //  Returns false once past the last entry
+        bool printLogLine(uint16_t);
+
         // Print all of the logs written to EPROM
         void printLogs();
 
-        // Print the temperature and humidity given
-        void printReading(Print&, float, float);
+        // Print the temperature and humidity given, in tenths
+        void printReading(Print&, int16_t, int16_t);
 
         // Print current status of the controller
         void printStatus(Print&);
 
-        // Print given temperature in F or C
-        void printTemperature(Print&, float);
+        // Print given temperature, tenths of a degree C, in F or C
+        void printTemperature(Print&, int16_t);
+
+        // Print a value in tenths with its one decimal
+        static void printTenths(Print&, int16_t);
 
         // Save temperature gates to EEPROM and set them
         void setAlarmGates(int, int, int, int);
@@ -95,8 +113,8 @@ class dht_control
         // Set the controllers scale setting to F if true otherwise C
         void setToFahrenheit(bool);
 
-        // Convert a C temp to F
-        int toFahrenheit(float);
+        // Convert tenths of a degree C to tenths of a degree F
+        int16_t toFahrenheit(int16_t);
 
         // Just toggles whether the monitor flag is active or not and prints
         void toggleMonitor();
@@ -0,0 +1,362 @@
+// dht_log.cpp
+#include "dht_log.h"
+#include "calendar.h"
+
+#define DEBUG 0
+
+extern eeprom_cache EECACHE;
+
+// Block layout offsets
+#define LOG_SEQ 0
+#define LOG_COUNT 1
+#define LOG_TIME 2
+#define LOG_TEMP 6
+#define LOG_HUMID 7
+#define LOG_DELTAS 8
+#define LOG_DELTA_BITS ((LOG_BLOCK_SIZE - LOG_DELTAS) * 8)
+// Every delta record is at least 3 bits
+#define LOG_MAX_RECORDS (1 + LOG_DELTA_BITS / 3)
+
+// Small and large field widths, see dht_log.h
+#define INTERVAL_SMALL 3
+#define INTERVAL_LARGE 8
+#define TEMP_SMALL 2
+#define TEMP_LARGE 5
+#define HUMID_SMALL 2
+#define HUMID_LARGE 6
+
+// Sequence numbers count 0-254 and wrap, 255 is an erased cell
+#define nextSeq(seq) ((seq) == 254 ? 0 : (seq) + 1)
+#define nextSlot(slot) ((slot) + 1 == LOG_BLOCKS ? 0 : (slot) + 1)
+
+static bool fits(int16_t v, uint8_t width) {
+    return v >= -(1 << (width - 1)) && v < (1 << (width - 1));
+}
+
+// Append a field's code to bits, false if it is too big for either class
+static bool encodeField(int16_t v, uint8_t small, uint8_t large,
+        uint32_t &bits, uint8_t &n) {
+    if (v == 0) {
+        bits <<= 1;
+        n += 1;
+    }
+    else if (fits(v, small)) {
+        bits = (bits << (2 + small)) | (2UL << small) |
+                (v & ((1 << small) - 1));
+        n += 2 + small;
+    }
+    else if (fits(v, large)) {
+        bits = (bits << (3 + large)) | (6UL << large) |
+                (v & ((1 << large) - 1));
+        n += 3 + large;
+    }
+    else
+        return false;
+    return true;
+}
+
+// Pulls bits MSB first out of a block's delta area
+static uint16_t readBits(uint16_t address, uint8_t &bit, uint8_t n) {
+    uint16_t v = 0;
+    while (n--) {
+        uint8_t b = EECACHE.read(address + LOG_DELTAS + (bit >> 3));
+        v = (v << 1) | ((b >> (7 - (bit & 7))) & 1);
+        bit++;
+    }
+    return v;
+}
+
+static bool decodeField(uint16_t address, uint8_t &bit, uint8_t small,
+        uint8_t large, int16_t &v) {
+    if (readBits(address, bit, 1) == 0) {
+        v = 0;
+        return true;
+    }
+    uint8_t width;
+    if (readBits(address, bit, 1) == 0)
+        width = small;
+    else if (readBits(address, bit, 1) == 0)
+        width = large;
+    else
+        return false; // 111 is never written
+    uint16_t raw = readBits(address, bit, width);
+    // Sign extend
+    if (raw & (1 << (width - 1)))
+        v = (int16_t)raw - (1 << width);
+    else
+        v = raw;
+    return true;
+}
+
+uint16_t dht_log::blockAddress(uint8_t slot) {
+    return start + slot * LOG_BLOCK_SIZE;
+}
+
+uint8_t dht_log::blockSeq(uint8_t slot) {
+    uint16_t address = blockAddress(slot);
+    uint8_t seq = EECACHE.read(address + LOG_SEQ);
+    uint8_t n = EECACHE.read(address + LOG_COUNT);
+    if (n == 0 || n > LOG_MAX_RECORDS)
+        return LOG_SEQ_EMPTY;
+    return seq;
+}
+
+void dht_log::begin(uint16_t address, uint16_t stats_address,
+        uint16_t seconds) {
+    start = address;
+    summary = stats_address;
+    period = seconds;
+    blocks = 0;
+    entries = 0;
+    reader.index = 0xFFFF;
+    // The newest block is the one whose next slot doesn't carry on its
+    //  sequence. With fewer slots than sequence numbers there is only one.
+    for (uint8_t slot = 0; slot < LOG_BLOCKS; slot++) {
+        uint8_t seq = blockSeq(slot);
+        if (seq == LOG_SEQ_EMPTY)
+            continue;
+        if (blockSeq(nextSlot(slot)) != nextSeq(seq)) {
+            head = slot;
+            head_seq = seq;
+            blocks = 1;
+            break;
+        }
+    }
+    resetTotals();
+    if (blocks == 0)
+        return;
+    entries = EECACHE.read(blockAddress(head) + LOG_COUNT);
+    // Count back through the blocks that lead up to it
+    uint8_t slot = head, seq = head_seq;
+    while (blocks < LOG_BLOCKS) {
+        slot = (slot + LOG_BLOCKS - 1) % LOG_BLOCKS;
+        uint8_t prev = blockSeq(slot);
+        if (prev == LOG_SEQ_EMPTY || nextSeq(prev) != seq)
+            break;
+        seq = prev;
+        blocks++;
+        entries += EECACHE.read(blockAddress(slot) + LOG_COUNT);
+    }
+    // Decode the newest block so appends can carry on from its last record.
+    //  The summary covers everything before it, or all of it if a reset
+    //  came between saving the summary and starting the next block.
+    uint8_t saved_seq;
+    bool saved = loadSummary(saved_seq);
+    bool add_head = saved && saved_seq == head_seq;
+    uint8_t n = EECACHE.read(blockAddress(head) + LOG_COUNT);
+    openBlock(tail, head, entries - n);
+    if (add_head)
+        addToTotals(tail.temp, tail.humid);
+    while (nextRecord(tail))
+        if (add_head)
+            addToTotals(tail.temp, tail.humid);
+    // Otherwise rebuild from what the log still holds
+    if (!add_head && !(saved && saved_seq == nextSeq(head_seq))) {
+        resetTotals();
+        for (uint16_t i = 0; i < entries; i++) {
+            log_entry entry = get(i);
+            addToTotals(entry.temp / 10, entry.humid / 10);
+        }
+    }
+    #if DEBUG >= 1
+    Serial.print(F("Log head, blocks, entries: "));
+    Serial.print(head); Serial.print(F(" "));
+    Serial.print(blocks); Serial.print(F(" "));
+    Serial.println(entries);
+    #endif
+}
+
+void dht_log::clear() {
+    // Only the sequence numbers need erasing. The head stays put so the
+    //  next block carries on round the ring instead of reusing slot 0.
+    for (uint8_t slot = 0; slot < LOG_BLOCKS; slot++)
+        EECACHE.write(blockAddress(slot) + LOG_SEQ, LOG_SEQ_EMPTY);
+    blocks = 0;
+    entries = 0;
+    reader.index = 0xFFFF;
+    resetTotals();
+}
+
+void dht_log::resetTotals() {
+    totals.count = 0;
+    totals.temp_sum = 0;
+    totals.humid_sum = 0;
+    totals.temp_min = INT8_MAX;
+    totals.temp_max = INT8_MIN;
+    totals.humid_min = UINT8_MAX;
+    totals.humid_max = 0;
+}
+
+void dht_log::addToTotals(int8_t temp, uint8_t humid) {
+    totals.count++;
+    totals.temp_sum += temp;
+    totals.humid_sum += humid;
+    totals.temp_min = min(totals.temp_min, temp);
+    totals.temp_max = max(totals.temp_max, temp);
+    totals.humid_min = min(totals.humid_min, humid);
+    totals.humid_max = max(totals.humid_max, humid);
+}
+
+static uint8_t summaryCheck(const log_stats &stats, uint8_t seq) {
+    const uint8_t *p = (const uint8_t*)&stats;
+    uint8_t check = seq ^ 0x5A;
+    for (uint8_t i = 0; i < sizeof(log_stats); i++)
+        check = (check << 1 | check >> 7) + p[i];
+    return check;
+}
+
+void dht_log::saveSummary(uint8_t seq) {
+    EECACHE.put(summary, totals);
+    EECACHE.write(summary + sizeof(log_stats), seq);
+    EECACHE.flush();
+    EECACHE.write(summary + sizeof(log_stats) + 1, summaryCheck(totals, seq));
+}
+
+bool dht_log::loadSummary(uint8_t &seq) {
+    log_stats stats;
+    EECACHE.get(summary, stats);
+    seq = EECACHE.read(summary + sizeof(log_stats));
+    if (EECACHE.read(summary + sizeof(log_stats) + 1) != summaryCheck(stats, seq))
+        return false;
+    totals = stats;
+    return true;
+}
+
+void dht_log::openBlock(log_cursor &c, uint8_t slot, uint16_t index) {
+    uint16_t address = blockAddress(slot);
+    c.index = index;
+    c.block = slot;
+    c.record = 0;
+    c.bit = 0;
+    EECACHE.get(address + LOG_TIME, c.time);
+    c.interval = period;
+    c.temp = EECACHE.read(address + LOG_TEMP);
+    c.humid = EECACHE.read(address + LOG_HUMID);
+}
+
+bool dht_log::nextRecord(log_cursor &c) {
+    uint16_t address = blockAddress(c.block);
+    if (c.record + 1 >= EECACHE.read(address + LOG_COUNT))
+        return false;
+    int16_t interval, temp, humid;
+    uint8_t bit = c.bit;
+    if (!decodeField(address, bit, INTERVAL_SMALL, INTERVAL_LARGE, interval) ||
+            !decodeField(address, bit, TEMP_SMALL, TEMP_LARGE, temp) ||
+            !decodeField(address, bit, HUMID_SMALL, HUMID_LARGE, humid))
+        return false;
+    c.bit = bit;
+    c.interval += interval;
+    c.time += c.interval;
+    c.temp += temp;
+    c.humid += humid;
+    c.record++;
+    c.index++;
+    return true;
+}
+
+void dht_log::startBlock(uint32_t time, int8_t temp, uint8_t humid) {
+    uint8_t slot = nextSlot(head);
+    uint8_t seq = blocks ? nextSeq(head_seq) : 0;
+    uint16_t address = blockAddress(slot);
+    // Ring is full, the oldest block goes
+    if (blocks == LOG_BLOCKS) {
+        entries -= EECACHE.read(address + LOG_COUNT);
+        blocks--;
+    }
+    saveSummary(seq);
+    // Erase the sequence number first and write it last, so a reset
+    //  part way through loses the oldest block instead of garbling it
+    EECACHE.write(address + LOG_SEQ, LOG_SEQ_EMPTY);
+    EECACHE.flush();
+    EECACHE.write(address + LOG_COUNT, 1);
+    EECACHE.put(address + LOG_TIME, time);
+    EECACHE.write(address + LOG_TEMP, temp);
+    EECACHE.write(address + LOG_HUMID, humid);
+    EECACHE.flush();
+    EECACHE.write(address + LOG_SEQ, seq);
+    head = slot;
+    head_seq = seq;
+    blocks++;
+    entries++;
+    openBlock(tail, slot, entries - 1);
+    // Indexes have shifted if a block was dropped
+    reader.index = 0xFFFF;
+}
+
+void dht_log::append(const log_entry &entry) {
+    uint32_t time = toEpoch(entry.ts);
+    int8_t temp = roundTenths(entry.temp);
+    uint8_t humid = roundTenths(entry.humid);
+    if (entries == 0 || !appendDelta(time, temp, humid))
+        startBlock(time, temp, humid);
+    // After startBlock, whose summary covers only the entries before it
+    addToTotals(temp, humid);
+}
+
+bool dht_log::appendDelta(uint32_t time, int8_t temp, uint8_t humid) {
+    int32_t interval = (int32_t)(time - tail.time);
+    int32_t change = interval - tail.interval;
+    uint32_t bits = 0;
+    uint8_t n = 0;
+    // A clock change or a long gap doesn't fit a delta
+    if (interval < -32768 || interval > 32767 ||
+            change < -32768 || change > 32767 ||
+            !encodeField(change, INTERVAL_SMALL, INTERVAL_LARGE, bits, n) ||
+            !encodeField(temp - tail.temp, TEMP_SMALL, TEMP_LARGE, bits, n) ||
+            !encodeField(humid - tail.humid, HUMID_SMALL, HUMID_LARGE, bits, n) ||
+            tail.bit + n > LOG_DELTA_BITS)
+        return false;
+
+    // Merge the record into the bytes it touches, one write per byte
+    uint16_t address = blockAddress(tail.block);
+    uint16_t at = address + LOG_DELTAS + (tail.bit >> 3);
+    uint8_t offset = tail.bit & 7;
+    for (uint8_t left = n; left > 0; ) {
+        uint8_t room = 8 - offset;
+        uint8_t take = min(room, left);
+        uint8_t shift = room - take;
+        uint8_t mask = ((1 << take) - 1) << shift;
+        uint8_t chunk = (bits >> (left - take)) << shift;
+        EECACHE.write(at, (EECACHE.read(at) & ~mask) | (chunk & mask));
+        left -= take;
+        offset = 0;
+        at++;
+    }
+    // The count commits the record, so the bits go down first
+    EECACHE.flush();
+    EECACHE.write(address + LOG_COUNT, tail.record + 2);
+
+    tail.bit += n;
+    tail.interval = interval;
+    tail.time = time;
+    tail.temp = temp;
+    tail.humid = humid;
+    tail.record++;
+    tail.index++;
+    entries++;
+    return true;
+}
+
+log_entry dht_log::get(uint16_t i) {
+    log_entry entry = {};
+    if (i >= entries)
+        return entry;
+    // Start over from the oldest block unless reading on from last time
+    if (reader.index > i || reader.index >= entries) {
+        uint8_t oldest = (head + 1 + LOG_BLOCKS - blocks) % LOG_BLOCKS;
+        openBlock(reader, oldest, 0);
+    }
+    while (reader.index < i) {
+        uint8_t n = EECACHE.read(blockAddress(reader.block) + LOG_COUNT);
+        uint16_t first = reader.index - reader.record;
+        // Skip whole blocks without decoding them
+        if (i >= first + n)
+            openBlock(reader, nextSlot(reader.block), first + n);
+        else if (!nextRecord(reader))
+            break; // Corrupt record, the rest of the block is lost
+    }
+    entry.ts = fromEpoch(reader.time);
+    entry.temp = reader.temp * 10;
+    entry.humid = reader.humid * 10;
+    return entry;
+}
@@ -0,0 +1,128 @@
+// dht_log.h
+/* Compressed DHT log in EEPROM. The log region is a ring of fixed size
+        blocks, each holding one absolute keyframe and then as many small
+        bit-packed deltas as fit.
+    Block layout (LOG_BLOCK_SIZE bytes):
+        seq ...... 1  Sequence number, LOG_SEQ_EMPTY while unwritten
+        count .... 1  Records in the block, keyframe included
+        time ..... 4  Keyframe, seconds since 2000, little-endian
+        temp ..... 1
+        humid .... 1
+        deltas ... 11 Bit-packed, MSB first
+    Each delta record is three signed fields: the change in log interval
+        (so steady logging is 0), the change in temperature and the change
+        in humidity. Each field is coded as
+            0                0
+            10 + small bits  small change
+            110 + large bits larger change
+        and anything bigger, or a full block, starts a new keyframe.
+    Blocks carry their own sequence number, so there is no header cell
+        rewritten on every log and the newest block is found by scanning.
+    Readings come in as tenths but are kept to the nearest whole degree C
+        and %RH, deltas in tenths would take several times the bits.
+    Running statistics since the last clear are kept in RAM and saved to a
+        separate summary each time a block starts, tagged with that block's
+        sequence number. Boot adds the newest block's records on top, so
+        the summary is written once per block rather than once per log.
+    Summary layout (LOG_SUMMARY_SIZE bytes):
+        stats .... 16 log_stats
+        seq ...... 1  Block the summary leads up to
+        check .... 1  Written last, a torn summary is rebuilt from the log */
+#ifndef DHT_LOG_H
+#define DHT_LOG_H
+
+#include <Arduino.h>
+#include <DS3231_Simple.h>
+#include "eeprom_cache.h"
+
+#define LOG_BLOCK_SIZE 19
+#define LOG_BLOCKS 13       // 247 bytes
+#define LOG_FORMAT 1        // Bump with the layout, the log is cleared on a change
+#define LOG_SEQ_EMPTY 0xFF
+#define LOG_SUMMARY_SIZE (sizeof(log_stats) + 2)
+
+struct log_entry {
+    DateTime ts;
+    int16_t temp;   // Tenths of a degree C
+    int16_t humid;  // Tenths of %RH
+};
+
+// Nearest whole unit of a value in tenths, halves away from zero
+inline int16_t roundTenths(int16_t t) {
+    return (t + (t < 0 ? -5 : 5)) / 10;
+}
+
+// Running aggregates, whole degrees C and %RH as logged
+struct log_stats {
+    uint32_t count;
+    int32_t temp_sum;
+    uint32_t humid_sum;
+    int8_t temp_min, temp_max;
+    uint8_t humid_min, humid_max;
+};
+
+// Position in the log and the values decoded up to it
+struct log_cursor {
+    uint16_t index;     // Entry the cursor is on, oldest is 0
+    uint8_t block;      // Slot of its block
+    uint8_t record;     // Record within the block
+    uint8_t bit;        // Where the next record's bits start
+    uint32_t time;
+    int16_t interval;   // Seconds since the record before
+    int8_t temp;
+    uint8_t humid;
+};
+
+class dht_log
+{
+    private:
+        uint16_t start;
+        uint16_t summary;       // Address of the saved statistics
+        uint16_t period;        // Expected seconds between logs
+        uint8_t head = 0;       // Slot of the newest block
+        uint8_t head_seq = 0;
+        uint8_t blocks = 0;     // Blocks in use, ending at head
+        uint16_t entries = 0;
+        log_cursor tail;        // On the newest entry, for appending
+        log_cursor reader;      // Where get() last stopped
+        log_stats totals;       // Every entry since the last clear
+
+        uint16_t blockAddress(uint8_t);
+        // Sequence number of a block, LOG_SEQ_EMPTY if it isn't usable
+        uint8_t blockSeq(uint8_t);
+        // Point a cursor at a block's keyframe
+        void openBlock(log_cursor&, uint8_t, uint16_t);
+        // Decode the next record in the cursor's block into it
+        bool nextRecord(log_cursor&);
+        // Write a keyframe into the next slot round the ring
+        void startBlock(uint32_t, int8_t, uint8_t);
+        // Add a record as a delta on the tail, false if it won't fit
+        bool appendDelta(uint32_t, int8_t, uint8_t);
+        // Save totals as covering everything before block seq
+        void saveSummary(uint8_t);
+        // Load the totals, false if the summary is torn or doesn't match
+        bool loadSummary(uint8_t&);
+        void resetTotals();
+        void addToTotals(int8_t, uint8_t);
+    public:
+        // Find the newest block and the run of blocks before it, then
+        //  bring the statistics up to date
+        //  Takes the EEPROM addresses of the log and its summary, and the
+        //  expected seconds between logs
+        void begin(uint16_t, uint16_t, uint16_t);
+
+        // Forget every entry
+        void clear();
+
+        void append(const log_entry&);
+
+        uint16_t count() { return entries; }
+
+        // Statistics since the last clear, they outlive dropped blocks
+        const log_stats &stats() { return totals; }
+
+        // Entry i, oldest first. Reading in order decodes each one once.
+        log_entry get(uint16_t);
+};
+
+#endif
@@ -0,0 +1,252 @@
+// eeprom_cache.cpp
+#include "eeprom_cache.h"
+#include <avr/eeprom.h>
+
+#define DEBUG 0
+
+#define QUEUE_MASK (EEC_QUEUE - 1)
+static_assert((EEC_QUEUE & QUEUE_MASK) == 0 && EEC_QUEUE <= 128,
+        "EEC_QUEUE must be a power of two no bigger than 128");
+
+extern task_scheduler TASKS;
+
+// Shared with the ISR. Head and tail run free and are masked on access,
+//  only the ISR moves the tail. The entries are volatile too, so their
+//  stores can't be moved past the head that hands them over.
+static volatile uint16_t queue_address[EEC_QUEUE];
+static volatile uint8_t queue_value[EEC_QUEUE];
+static volatile uint8_t queue_head = 0, queue_tail = 0;
+static volatile uint32_t isr_saved = 0, isr_written = 0;
+
+// Starts the next byte that differs from the EEPROM, or turns itself off
+//  once the queue is empty. The EEPROM is free whenever this runs.
+ISR(EE_READY_vect) {
+    while (queue_tail != queue_head) {
+        uint8_t i = queue_tail & QUEUE_MASK;
+        queue_tail++;
+        EEAR = queue_address[i];
+        EECR |= _BV(EERE);
+        if (EEDR == queue_value[i]) {
+            isr_saved++;
+            continue;
+        }
+        EEDR = queue_value[i];
+        // EEPE has to follow EEMPE within four cycles
+        EECR |= _BV(EEMPE);
+        EECR |= _BV(EEPE);
+        isr_written++;
+        return;
+    }
+    EECR &= ~_BV(EERIE);
+}
+
+// Read a byte from the EEPROM itself, with EE_READY held off meanwhile.
+//  Left on, it starts the next queued byte as soon as one finishes, so
+//  waiting for EEPE would wait out the whole queue, and a write it started
+//  between the wait and the read would move EEAR under it. Without wait,
+//  returns false rather than wait out a byte being written.
+static bool readCell(uint16_t address, uint8_t &value, bool wait) {
+    bool writer = EECR & _BV(EERIE);
+    EECR &= ~_BV(EERIE);
+    bool busy = EECR & _BV(EEPE);
+    if (busy && wait) {
+        eeprom_busy_wait();
+        busy = false;
+    }
+    if (!busy) {
+        EEAR = address;
+        EECR |= _BV(EERE);
+        value = EEDR;
+    }
+    if (writer)
+        EECR |= _BV(EERIE);
+    return !busy;
+}
+
+eeprom_cache::eeprom_cache() {
+    for (uint8_t i = 0; i < EEC_LINES; i++) {
+        lines[i].tag = EEC_NO_LINE;
+        lines[i].dirty = 0;
+    }
+}
+
+void eeprom_cache::setup() {
+    flush_task = TASKS.add(F("eeprom"), flushTask, this, 0);
+    TASKS.stop(flush_task);
+}
+
+eec_line *eeprom_cache::findLine(uint16_t address) {
+    uint8_t tag = address / EEC_LINE_SIZE;
+    for (uint8_t i = 0; i < EEC_LINES; i++)
+        if (lines[i].tag == tag)
+            return &lines[i];
+    return NULL;
+}
+
+bool eeprom_cache::enqueue(uint16_t address, uint8_t value) {
+    uint8_t head = queue_head;
+    uint8_t depth = head - queue_tail;
+    if (depth >= EEC_QUEUE)
+        return false;
+    queue_address[head & QUEUE_MASK] = address;
+    queue_value[head & QUEUE_MASK] = value;
+    queue_head = head + 1;
+    queue_peak = max(queue_peak, (uint8_t)(depth + 1));
+    EECR |= _BV(EERIE);
+    return true;
+}
+
+bool eeprom_cache::findQueued(uint16_t address, uint8_t &value) {
+    // Newest first. An entry the ISR takes meanwhile still holds the value
+    //  it is writing, and readCell() waits for that write to finish.
+    uint8_t tail = queue_tail;
+    for (uint8_t i = queue_head; i != tail; ) {
+        i--;
+        if (queue_address[i & QUEUE_MASK] == address) {
+            value = queue_value[i & QUEUE_MASK];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t eeprom_cache::read(uint16_t address) {
+    eec_line *line = findLine(address);
+    uint8_t offset = address % EEC_LINE_SIZE;
+    if (line && bitRead(line->dirty, offset))
+        return line->data[offset];
+    uint8_t value;
+    if (!findQueued(address, value))
+        readCell(address, value, true);
+    return value;
+}
+
+void eeprom_cache::write(uint16_t address, uint8_t value) {
+    issued++;
+    eec_line *line = findLine(address);
+    uint8_t offset = address % EEC_LINE_SIZE;
+    if (line && bitRead(line->dirty, offset)) {
+        // The pending write it replaces never happens
+        line->data[offset] = value;
+        saved++;
+        return;
+    }
+    // Drop it if it changes nothing. Checking the EEPROM itself would wait
+    //  out a write in progress, so then the ISR checks it instead.
+    uint8_t current;
+    bool known = findQueued(address, current) ||
+            readCell(address, current, false);
+    if (known && current == value) {
+        saved++;
+        return;
+    }
+    if (!line) {
+        for (uint8_t i = 0; i < EEC_LINES && !line; i++)
+            if (lines[i].tag == EEC_NO_LINE)
+                line = &lines[i];
+        if (!line) {
+            line = &lines[victim];
+            if (!flushLine(*line))
+                waitLine(*line);
+            victim = (victim + 1) % EEC_LINES;
+        }
+        line->tag = address / EEC_LINE_SIZE;
+    }
+    line->data[offset] = value;
+    bitSet(line->dirty, offset);
+    // The window starts at the first write, later ones don't push it back
+    if (!pending) {
+        pending = true;
+        TASKS.wake(flush_task, EEC_FLUSH_DELAY);
+    }
+}
+
+bool eeprom_cache::flushLine(eec_line &line) {
+    uint16_t address = line.tag * EEC_LINE_SIZE;
+    for (uint8_t i = 0; i < EEC_LINE_SIZE; i++) {
+        if (!bitRead(line.dirty, i))
+            continue;
+        if (!enqueue(address + i, line.data[i]))
+            return false;
+        bitClear(line.dirty, i);
+    }
+    line.tag = EEC_NO_LINE;
+    return true;
+}
+
+bool eeprom_cache::flushLines() {
+    bool done = true;
+    for (uint8_t i = 0; i < EEC_LINES; i++)
+        if (lines[i].tag != EEC_NO_LINE && !flushLine(lines[i]))
+            done = false;
+    return done;
+}
+
+void eeprom_cache::waitLine(eec_line &line) {
+    // Let the ISR make room, nothing can jump the queue
+    stalls++;
+    while (!flushLine(line))
+        delayMicroseconds(EEC_STALL_US);
+}
+
+void eeprom_cache::flushTask(void *ctx) {
+    eeprom_cache *cache = (eeprom_cache*)ctx;
+    // Nothing here needs to land before anything else, so what the queue
+    //  can't take stays in the lines until it has room
+    if (cache->flushLines()) {
+        cache->pending = false;
+        TASKS.stop(cache->flush_task);
+    }
+    else {
+        cache->deferred++;
+        TASKS.wake(cache->flush_task, EEC_RETRY_DELAY);
+    }
+}
+
+void eeprom_cache::flush() {
+    #if DEBUG >= 1
+    Serial.print(F("EEPROM queued "));
+    #endif
+    if (!flushLines())
+        for (uint8_t i = 0; i < EEC_LINES; i++)
+            if (lines[i].tag != EEC_NO_LINE)
+                waitLine(lines[i]);
+    pending = false;
+    TASKS.stop(flush_task);
+    #if DEBUG >= 1
+    Serial.println(queued());
+    #endif
+}
+
+uint8_t eeprom_cache::queued() {
+    return queue_head - queue_tail;
+}
+
+uint32_t eeprom_cache::writesSaved() {
+    noInterrupts();
+    uint32_t n = isr_saved;
+    interrupts();
+    return saved + n;
+}
+
+uint32_t eeprom_cache::bytesFlushed() {
+    noInterrupts();
+    uint32_t n = isr_written;
+    interrupts();
+    return n;
+}
+
+void eeprom_cache::printStats(Print &Printer) {
+    Printer.print(F("EEPROM writes "));
+    Printer.print(writesIssued());
+    Printer.print(F(", saved "));
+    Printer.print(writesSaved());
+    Printer.print(F(", flushed "));
+    Printer.print(bytesFlushed());
+    Printer.print(F(", queue peak "));
+    Printer.print(queue_peak);
+    Printer.print(F(", deferred "));
+    Printer.print(deferred);
+    Printer.print(F(", stalls "));
+    Printer.println(stalls);
+}
@@ -0,0 +1,114 @@
+// eeprom_cache.h
+/* Write-back cache and background writer in front of the EEPROM. Every
+        saved setting and the log go through it.
+    Writes land in a few RAM lines and are handed to the writer
+        EEC_FLUSH_DELAY after the first one, so repeated saves of the same
+        bytes inside that window cost one erase/write each.
+    The writer is a queue drained one byte per EEPROM ready interrupt, so
+        the 3.3ms each byte takes runs alongside the sketch instead of
+        blocking it. Bytes that already match the EEPROM are skipped, both
+        when written and when the interrupt gets to them.
+    Reads see pending writes, from the lines and then the queue. Lines are
+        only taken by writes, so reading through the log doesn't push them
+        out. Reading a byte that isn't pending still waits out a byte being
+        written, the EEPROM can't do both, but holds the writer off so it is
+        only the one byte and not the rest of the queue.
+    The queue keeps the order bytes were flushed in, but a flush goes line
+        by line. Code that relies on one write landing before another for
+        reset safety calls flush() between them.
+    The flush task never waits for the queue: bytes it has no room for stay
+        in their lines and it tries again EEC_RETRY_DELAY later. flush()
+        and taking a line for a write can't leave bytes behind, so they
+        wait for room in a full queue, counted as a stall. The queue holds
+        a first boot's config save and log setup, so that takes a burst
+        bigger than the lines and the queue together. */
+#ifndef EEPROM_CACHE_H
+#define EEPROM_CACHE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "scheduler.h"
+
+#define EEC_LINES 4
+#define EEC_LINE_SIZE 16     // At most 16, one dirty bit per byte
+#define EEC_NO_LINE 0xFF
+#define EEC_FLUSH_DELAY 2000 // ms
+#define EEC_QUEUE 64         // Power of two, at most 128
+#define EEC_RETRY_DELAY 50   // ms, flush task waiting on a full queue
+#define EEC_STALL_US 500     // Wait between retries on a full queue
+
+struct eec_line {
+    uint8_t tag;            // Address / EEC_LINE_SIZE, EEC_NO_LINE if free
+    uint16_t dirty;         // Bytes holding a pending write
+    uint8_t data[EEC_LINE_SIZE];
+};
+
+class eeprom_cache
+{
+    private:
+        eec_line lines[EEC_LINES];
+        uint8_t victim = 0;     // Next line to evict, round robin
+        uint8_t flush_task = TASK_NONE;
+        bool pending = false;   // flush_task is armed
+        uint32_t issued = 0;    // Bytes asked to be written
+        uint32_t saved = 0;     // Of those, dropped before the queue
+
+        // One-shot, woken by the first write after a flush
+        static void flushTask(void*);
+        eec_line *findLine(uint16_t);
+        // Queue a line's dirty bytes and free it, false if the queue filled
+        //  first and some are still dirty
+        bool flushLine(eec_line&);
+        bool flushLines();
+        // Finish a line, waiting for the ISR to make room
+        void waitLine(eec_line&);
+        // Queue a byte for the interrupt, false if the queue is full
+        bool enqueue(uint16_t, uint8_t);
+        // Newest value queued for a byte, false if there isn't one
+        bool findQueued(uint16_t, uint8_t&);
+    public:
+        // Deepest the queue has been, flush task runs that left bytes for
+        //  later, and lines that had to wait for room in it
+        uint8_t queue_peak = 0;
+        uint16_t deferred = 0;
+        uint16_t stalls = 0;
+
+        eeprom_cache();
+
+        // Registers the flush task, writes before this wait for a flush()
+        void setup();
+
+        uint8_t read(uint16_t);
+        void write(uint16_t, uint8_t);
+
+        template <typename T> T &get(uint16_t address, T &t) {
+            uint8_t *p = (uint8_t*)&t;
+            for (uint8_t i = 0; i < sizeof(T); i++)
+                p[i] = read(address + i);
+            return t;
+        }
+
+        template <typename T> const T &put(uint16_t address, const T &t) {
+            const uint8_t *p = (const uint8_t*)&t;
+            for (uint8_t i = 0; i < sizeof(T); i++)
+                write(address + i, p[i]);
+            return t;
+        }
+
+        // Queue every pending byte now, in front of anything written later
+        void flush();
+
+        // Bytes in the queue not yet written
+        uint8_t queued();
+
+        // Bytes asked to be written, ones that never reached the EEPROM
+        //  because they were overwritten while pending or matched what was
+        //  already there, and ones actually written
+        uint32_t writesIssued() { return issued; }
+        uint32_t writesSaved();
+        uint32_t bytesFlushed();
+
+        void printStats(Print&);
+};
+
+#endif
@@ -1,100 +1,238 @@
 // fivebtn_analog.cpp
 #include "fivebtn_analog.h"
+#include "config_store.h"
 
 #define DEBUG 0
 
-#define DEBOUNCE_DELAY 100
+// Levels are readings / 4, anything from here up is no button at all
+#define RELEASED_LEVEL (255 - BTN_MIN_GAP)
 
-#define CONFIRM_VOLT_L 730
-#define CONFIRM_VOLT_U 750
-#define RIGHT_VOLT_L 490
-#define RIGHT_VOLT_U 510
-#define DOWN_VOLT_L 320
-#define DOWN_VOLT_U 340
-#define UP_VOLT_L 140
-#define UP_VOLT_U 160
-#define LEFT_VOLT_L 0
-#define LEFT_VOLT_U 20
+extern config_store CONFIG;
+
+#define QUEUE_MASK (BTN_QUEUE - 1)
+static_assert((BTN_QUEUE & QUEUE_MASK) == 0 && BTN_QUEUE <= 128,
+        "BTN_QUEUE must be a power of two no bigger than 128");
+
+// Shared with the ISR. Head and tail run free and are masked on access,
+//  only the ISR moves the head. The events are copied whole, so instead of
+//  being volatile they are fenced off from the head and tail moves.
+static button_event queue[BTN_QUEUE];
+#define QUEUE_FENCE() asm volatile("" ::: "memory")
+static volatile uint8_t queue_head = 0, queue_tail = 0;
+static volatile uint16_t queued = 0, dropped = 0;
+// ISR only
+static byte candidate = five_btn::NO_BTN;   // Latest reading
+static byte pressed = five_btn::NO_BTN;     // Debounced button
+static uint8_t stable = 0;                  // Samples candidate has held
+static uint8_t held = 0;                    // Samples since down or repeat
+
+// Button for each level, two to a byte, low nibble for the even level
+static uint8_t decode[128];
+
+// Calibration, the ISR owns it from calibrate() until CAL_SAMPLED or
+//  CAL_TIMED_OUT, then finishCalibration() does
+static volatile byte cal_step = five_btn::CAL_IDLE;
+static uint8_t cal_levels[CONFIG_BUTTONS];
+static uint8_t cal_level = 0;       // Level being timed
+static uint8_t cal_stable = 0;      // Samples it has held, give or take 1
+static bool cal_down = false;       // Asked for button is held
+static uint16_t cal_wait = 0;       // Samples since the last button
+
+static void push(byte btn, byte status) {
+    uint8_t head = queue_head;
+    if ((uint8_t)(head - queue_tail) >= BTN_QUEUE) {
+        dropped++;
+        return;
+    }
+    button_event &e = queue[head & QUEUE_MASK];
+    e.btn = btn;
+    e.status = status;
+    e.at = millis();
+    QUEUE_FENCE();
+    queue_head = head + 1;
+    queued++;
+}
+
+// Time the level, record it once it settles below released and move on
+//  once it settles back up
+static void calibrateSample(uint8_t level) {
+    if (++cal_wait >= BTN_CAL_TIMEOUT) {
+        cal_step = five_btn::CAL_TIMED_OUT;
+        return;
+    }
+    if (level + 1 < cal_level || level > cal_level + 1) {
+        cal_level = level;
+        cal_stable = 0;
+        return;
+    }
+    if (cal_stable == BTN_DEBOUNCE_SAMPLES || ++cal_stable < BTN_DEBOUNCE_SAMPLES)
+        return;
+    bool down = level < RELEASED_LEVEL;
+    if (down && !cal_down) {
+        cal_levels[cal_step - 1] = level;
+        cal_down = true;
+    }
+    else if (!down && cal_down) {
+        cal_down = false;
+        cal_wait = 0;
+        cal_step = cal_step < CONFIG_BUTTONS ? cal_step + 1 :
+                five_btn::CAL_SAMPLED;
+    }
+}
+
+// A conversion finished, one per timer0 overflow
+ISR(ADC_vect) {
+    uint16_t reading = ADC;
+    byte step = cal_step;
+    if (step != five_btn::CAL_IDLE && step <= five_btn::CAL_TIMED_OUT) {
+        if (step <= CONFIG_BUTTONS)
+            calibrateSample(reading >> 2);
+        return;
+    }
+    byte btn = five_btn::read(reading);
+    if (btn != candidate) {
+        candidate = btn;
+        stable = 0;
+        return;
+    }
+    if (stable < BTN_DEBOUNCE_SAMPLES && ++stable == BTN_DEBOUNCE_SAMPLES &&
+            btn != pressed) {
+        if (pressed != five_btn::NO_BTN)
+            push(pressed, five_btn::ON_BUTTON_UP);
+        if (btn != five_btn::NO_BTN)
+            push(btn, five_btn::ON_BUTTON_DOWN);
+        pressed = btn;
+        held = 0;
+    }
+    else if (btn == pressed && btn != five_btn::NO_BTN &&
+            ++held == BTN_HOLD_SAMPLES) {
+        push(btn, five_btn::ON_BUTTON_HELD);
+        held = BTN_HOLD_SAMPLES - BTN_REPEAT_SAMPLES;
+    }
+}
 
 five_btn::five_btn() {
     pinMode(A0, INPUT);
 }
 
-button_event five_btn::getButton() {
-    // Get button pressed
-    byte button_press = read();
-    button_event result = {0 , 0};
-
-    if (millis() - last_press_time > DEBOUNCE_DELAY) {
-        #if DEBUG == 4
-        if (button_press) Serial.println(button_press);
-        #endif
-        // Button state has persisted for longer than our delay
-        // Check what state it is and return value accordingly
-        // Button down
-        if (button_press && last_press == NO_BTN) {
-            result.btn = button_press;
-            result.status = ON_BUTTON_DOWN;
-            #if DEBUG >= 1
-            Serial.print("Button Down: ");
-            Serial.println(result.btn);
-            #endif
-        }
-        // Button up
-        else if (last_press && button_press == NO_BTN) {
-            result.btn = last_press;
-            result.status = ON_BUTTON_UP;
-            #if DEBUG >= 1
-            Serial.print("Button Up: ");
-            Serial.println(result.btn);
-            #endif
+bool five_btn::build(const uint8_t *levels) {
+    // Buttons in order of level
+    uint8_t order[CONFIG_BUTTONS];
+    for (uint8_t i = 0; i < CONFIG_BUTTONS; i++) {
+        uint8_t j = i;
+        for (; j > 0 && levels[order[j-1]] > levels[i]; j--)
+            order[j] = order[j-1];
+        order[j] = i;
+    }
+    for (uint8_t i = 1; i < CONFIG_BUTTONS; i++)
+        if (levels[order[i]] - levels[order[i-1]] < BTN_MIN_GAP)
+            return false;
+    if (levels[order[CONFIG_BUTTONS-1]] > RELEASED_LEVEL - BTN_MIN_GAP)
+        return false;
+
+    uint16_t level = 0;
+    for (uint8_t i = 0; i <= CONFIG_BUTTONS; i++) {
+        // Up to halfway to the next level, the top one halfway to released
+        uint16_t upper = 255;
+        byte btn = NO_BTN;
+        if (i < CONFIG_BUTTONS) {
+            upper = ((uint16_t)levels[order[i]] + (i + 1 < CONFIG_BUTTONS ?
+                    levels[order[i+1]] : 255)) / 2;
+            btn = order[i] + 1;
         }
-        // Otherwise button held
-        else {
-            result.btn = button_press;
-            result.status = ON_BUTTON_HELD;
-            #if DEBUG >= 1
-            if (button_press != NO_BTN) {
-                Serial.print("Button Held: ");
-                Serial.println(result.btn);
-            }
-            #endif
+        for (; level <= upper; level++) {
+            uint8_t &pair = decode[level >> 1];
+            pair = level & 1 ? (pair & 0x0F) | btn << 4 : (pair & 0xF0) | btn;
         }
     }
+    return true;
+}
 
-    // If different from last, set timer
-    if (button_press != last_press)
-        last_press_time = millis();
+void five_btn::setup() {
+    if (!build(CONFIG.data.button_levels)) {
+        uint8_t levels[CONFIG_BUTTONS];
+        memcpy_P(levels, config_defaults.button_levels, sizeof(levels));
+        build(levels);
+    }
+    // AVcc reference, channel 0 (A0), 125kHz ADC clock, each conversion
+    //  started by timer0 overflowing
+    ADMUX = _BV(REFS0);
+    ADCSRB = _BV(ADTS2);
+    DIDR0 |= _BV(ADC0D);
+    ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) |
+            _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+}
 
-    // Save off reading to check in future call
-    last_press = button_press;
+void five_btn::calibrate() {
+    noInterrupts();
+    cal_level = 0;
+    cal_stable = 0;
+    cal_down = false;
+    cal_wait = 0;
+    // Decoding starts over afterwards, with nothing pressed
+    candidate = pressed = NO_BTN;
+    stable = 0;
+    cal_step = 1;
+    interrupts();
+}
 
-    return result;
+byte five_btn::calibrationStep() {
+    return cal_step;
 }
 
-byte five_btn::read() {
-    int reading = analogRead(A0);
-    #if DEBUG == 3
-        Serial.println(reading);
+bool five_btn::finishCalibration() {
+    if (cal_step != CAL_SAMPLED && cal_step != CAL_TIMED_OUT)
+        return false;
+    bool saved = cal_step == CAL_SAMPLED && build(cal_levels);
+    if (saved) {
+        memcpy(CONFIG.data.button_levels, cal_levels, sizeof(cal_levels));
+        CONFIG.save();
+    }
+    #if DEBUG >= 1
+    Serial.print(F("Button levels"));
+    for (uint8_t i = 0; i < CONFIG_BUTTONS; i++) {
+        Serial.print(' ');
+        Serial.print(cal_levels[i]);
+    }
+    Serial.println(saved ? F(" saved") : F(" not used"));
     #endif
-    if (reading > CONFIRM_VOLT_L &&
-            reading < CONFIRM_VOLT_U)
-        return OK_BTN;
-    if (reading > RIGHT_VOLT_L &&
-            reading < RIGHT_VOLT_U)
-        return RHT_BTN;
-    if (reading > DOWN_VOLT_L &&
-            reading < DOWN_VOLT_U)
-        return DWN_BTN;
-    if (reading > UP_VOLT_L &&
-            reading < UP_VOLT_U)
-        return UP_BTN;
-    if (reading > LEFT_VOLT_L &&
-            reading < LEFT_VOLT_U)
-        return LFT_BTN;
-    #if DEBUG == 2
-    if (reading >= 10)
-        Serial.println(reading);
+    cal_step = saved ? CAL_SAVED : CAL_FAILED;
+    return saved;
+}
+
+bool five_btn::getButton(button_event &event) {
+    uint8_t tail = queue_tail;
+    if (tail == queue_head)
+        return false;
+    QUEUE_FENCE();
+    event = queue[tail & QUEUE_MASK];
+    QUEUE_FENCE();
+    queue_tail = tail + 1;
+    uint16_t wait = (uint16_t)millis() - event.at;
+    max_wait = max(max_wait, wait);
+    #if DEBUG >= 1
+    Serial.print(F("Button "));
+    Serial.print(event.btn);
+    Serial.print(F(" status "));
+    Serial.println(event.status);
     #endif
-    return NO_BTN;
-}
\ No newline at end of file
+    return true;
+}
+
+void five_btn::printStats(Print &Printer) {
+    noInterrupts();
+    uint16_t n = queued, lost = dropped;
+    interrupts();
+    Printer.print(F("Buttons: events "));
+    Printer.print(n);
+    Printer.print(F(", dropped "));
+    Printer.print(lost);
+    Printer.print(F(", max wait "));
+    Printer.print(max_wait);
+    Printer.println(F("ms"));
+}
+
+byte five_btn::read(int reading) {
+    uint8_t level = reading >> 2;
+    return (level & 1 ? decode[level >> 1] >> 4 : decode[level >> 1]) & 0x0F;
+}
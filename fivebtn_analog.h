@@ -1,21 +1,45 @@
 // fivebtn_analog.h
 /* Module for identifying input from the five button analog
-        card, K845037. */
+        card, K845037.
+    The ADC samples the ladder on its own, triggered by every timer0
+        overflow (~1ms), and its interrupt debounces the readings and
+        queues timestamped events. The sketch only drains the queue, so a
+        press is never missed between polls and no poll waits on the ADC.
+        Nothing else may use the ADC while this runs, and there is only
+        the one ladder, on A0.
+    Readings are decoded by one lookup in a table indexed by the reading
+        / 4. Each button owns the span from halfway to the level below it
+        to halfway to the one above, so a reading that drifts with
+        temperature or supply sag still lands on its button. The levels
+        are the card's nominal ones until calibrate() samples the real
+        ones, which are kept in the config block. */
 #ifndef FIVEBTN_H
 #define FIVEBTN_H
 
 #include <Arduino.h>
 
+#define BTN_QUEUE 8             // Power of two, at most 128
+#define BTN_DEBOUNCE_SAMPLES 20 // Same reading this long is a change
+#define BTN_HOLD_SAMPLES 100    // Held this long starts repeating
+#define BTN_REPEAT_SAMPLES 10   // Then a held event this often
+#define BTN_MIN_GAP 8           // Closest two levels may be, reading / 4
+#define BTN_CAL_TIMEOUT 20000   // Samples calibration waits for a press
+
 struct button_event {
     byte btn:3;    // One of the 6 button names
     byte status:2; // One of 3 button states
+    uint16_t at;   // Low 16 bits of millis() when it was debounced
 };
 
 class five_btn
 {
     private:
-        byte last_press = 0;
-        unsigned long last_press_time = 0;
+        uint16_t max_wait = 0;  // Longest an event sat in the queue, ms
+
+        // Fill the decode table from a level per button, OK first. False,
+        //  leaving the table alone, if two are too close together or the
+        //  top one too close to released.
+        static bool build(const uint8_t*);
     public:
         static const byte NO_BTN = 0;
         static const byte OK_BTN = 1;
@@ -28,15 +52,37 @@ class five_btn
         static const byte ON_BUTTON_DOWN = 1;
         static const byte ON_BUTTON_UP = 2;
 
+        // Calibration steps, 1 to 5 is waiting for that button
+        static const byte CAL_IDLE = 0;
+        static const byte CAL_SAMPLED = 6;
+        static const byte CAL_TIMED_OUT = 7;
+        static const byte CAL_SAVED = 8;
+        static const byte CAL_FAILED = 9;
+
         // Constructor.
         five_btn();
 
-        // Return button event of the buttons
-        button_event getButton();
+        // Arduino setup call, builds the decode table from the config and
+        //  starts the ADC sampling
+        void setup();
+
+        // Ask for each button in turn, OK, Up, Down, Left then Right. No
+        //  events are queued until finishCalibration().
+        void calibrate();
+        // Where calibration is, one of the CAL_ steps
+        byte calibrationStep();
+        // Once sampled or timed out, saves the levels and decodes with
+        //  them if they are usable. True if they were saved.
+        bool finishCalibration();
+
+        // Take the oldest button event, false if there are none
+        bool getButton(button_event&);
+
+        // Return the button const a reading falls on, NO_BTN between them
+        static byte read(int);
 
-        // Read the analog input and return the const for that input
-        // Needs to be debounced for accuracy
-        byte read();
+        // Events queued, ones lost to a full queue and the longest wait
+        void printStats(Print&);
 };
 
-#endif
\ No newline at end of file
+#endif
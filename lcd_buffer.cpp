@@ -0,0 +1,66 @@
+// lcd_buffer.cpp
+#include "lcd_buffer.h"
+
+#define DEBUG 0
+
+lcd_buffer::lcd_buffer() {
+    clear();
+    memcpy(shown, cells, sizeof(shown));
+}
+
+void lcd_buffer::clear() {
+    memset(cells, ' ', sizeof(cells));
+    col = row = 0;
+    dirty = true;
+}
+
+void lcd_buffer::setCursor(uint8_t c, uint8_t r) {
+    col = c;
+    row = r < LCD_ROWS ? r : LCD_ROWS - 1;
+}
+
+size_t lcd_buffer::write(uint8_t c) {
+    if (col >= LCD_COLS)
+        return 0;
+    cells[row][col++] = c;
+    dirty = true;
+    return 1;
+}
+
+bool lcd_buffer::send(LiquidCrystal &display, uint16_t budget) {
+    if (!dirty)
+        return true;
+    uint32_t start = micros();
+    uint8_t sent = 0;
+    for (uint8_t r = 0; r < LCD_ROWS; r++) {
+        for (uint8_t c = 0; c < LCD_COLS; c++) {
+            if (cells[r][c] == shown[r][c])
+                continue;
+            // A cursor move costs about what a character does
+            uint8_t bytes = at_col != c || at_row != r ? 2 : 1;
+            uint32_t used = micros() - start;
+            if (sent && used + (uint32_t)byte_us * bytes > budget) {
+                #if DEBUG >= 2
+                Serial.print(F("LCD slice full: "));
+                Serial.println(sent);
+                #endif
+                return false;
+            }
+            uint32_t before = micros();
+            if (bytes == 2)
+                display.setCursor(c, r);
+            display.write(cells[r][c]);
+            byte_us = (micros() - before) / bytes;
+            shown[r][c] = cells[r][c];
+            sent += bytes;
+            at_col = c + 1;
+            at_row = r;
+        }
+    }
+    #if DEBUG >= 2
+    Serial.print(F("LCD bytes: "));
+    Serial.println(sent);
+    #endif
+    dirty = false;
+    return true;
+}
@@ -0,0 +1,55 @@
+// lcd_buffer.h
+/* RAM copy of the 16x2 screen. lcd_ui draws into it as it would into the
+        LCD, then show() sends the controller only the cells that differ
+        from what it last sent, so a redraw that changes nothing costs
+        nothing and there is no clear() flicker.
+    The HD44780 moves its address on after each character, so a run of
+        changed cells costs one cursor command and then a byte per cell.
+    Each byte still busy-waits in LiquidCrystal, so send() goes out in
+        slices with a time budget and picks up where it stopped on the next
+        call. Drawing over cells that haven't gone out yet just replaces
+        them, a stale frame is never sent. */
+#ifndef LCD_BUFFER_H
+#define LCD_BUFFER_H
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+
+#define LCD_COLS 16
+#define LCD_ROWS 2
+#define LCD_NO_CURSOR 255
+
+class lcd_buffer : public Print
+{
+    private:
+        uint8_t cells[LCD_ROWS][LCD_COLS];
+        uint8_t shown[LCD_ROWS][LCD_COLS];
+        uint8_t col = 0, row = 0;
+        // Where the controller will put the next character
+        uint8_t at_col = LCD_NO_CURSOR, at_row = 0;
+        bool dirty = false;     // Cells may differ from shown
+        uint16_t byte_us = 0;   // What the last byte sent took
+    public:
+        // Both copies start blank, as the LCD is after begin()
+        lcd_buffer();
+
+        // Blank the buffer, the LCD is untouched until send()
+        void clear();
+        void setCursor(uint8_t, uint8_t);
+        // Characters past the end of a row are dropped
+        size_t write(uint8_t);
+        using Print::write;
+
+        // Call after anything else moves the controller's address, such
+        //  as createChar()
+        void lostCursor() { at_col = LCD_NO_CURSOR; }
+
+        // Cells are waiting to go out
+        bool pending() { return dirty; }
+
+        // Send changed cells until the next byte would take it past the
+        //  budget in us, always at least one. True once everything is out.
+        bool send(LiquidCrystal&, uint16_t);
+};
+
+#endif
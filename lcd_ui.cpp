@@ -4,14 +4,19 @@
 #define DEBUG 0
 
 #define SCREEN_UPDATE_DELAY 5000
+#define BUTTON_POLL_DELAY 10
+// Most of a loop the LCD may take, a full screen goes out over a few polls
+#define LCD_SLICE_US 1000
 
 // Clock and Temp sensor are pulled from parent script.
 extern rtc_control RTC;
 extern dht_control DHT;
 extern network_control NET;
+extern task_scheduler TASKS;
 
 void lcd_ui::setup() {
-    lcd.begin(16,2);
+    analog.setup();
+    display.begin(LCD_COLS, LCD_ROWS);
     returnToHomeScreen();
 
     static const byte upDownArrow[8] = {
@@ -24,34 +29,87 @@ void lcd_ui::setup() {
         0b01010,
         0b00100,
     };
-    lcd.createChar(2, upDownArrow);
+    display.createChar(2, upDownArrow);
+    lcd.lostCursor();
+
+    // Either can draw a screen and send the first LCD_SLICE_US of it
+    TASKS.add(F("buttons"), inputTask, this, BUTTON_POLL_DELAY, 0, 2000);
+    TASKS.add(F("screen"), redrawTask, this, SCREEN_UPDATE_DELAY,
+            SCREEN_UPDATE_DELAY, 2000);
 }
 
-bool lcd_ui::loop() {
-    // Run input processing and update scren if needed
-    if ((editable_ints_active && editableIntsInputProcess()) ||
-            (!editable_ints_active && standardMenuInputProcess()))
-        updateScreen();
+// Rows the table refers to, children of a node have to be consecutive
+#define M_LOG_ENTRY 5
+#define M_TEMPS 6
 
-    static unsigned long loop_delay = 0;
-    // We only periodically redraw screen for these conditions
-    if (isHomeScreen() && millis() - loop_delay > SCREEN_UPDATE_DELAY) {
-        loop_delay = millis();
-        updateScreen();
+static const char l_logs[] PROGMEM = "Logs";
+static const char l_netstat[] PROGMEM = "Ntwrk Packets";
+static const char l_config[] PROGMEM = "Config";
+static const char l_temps[] PROGMEM = "Temp. Alarm";
+static const char l_ip[] PROGMEM = "Change IP Addr";
+static const char l_subnet[] PROGMEM = "Config Subnet";
+static const char l_gateway[] PROGMEM = "Config Gateway";
+static const char l_calibrate[] PROGMEM = "Calibrate Btns";
+static const char l_clearlogs[] PROGMEM = "Clear Logs?";
+// Buttons in the order calibration asks for them
+static const char cal_names[][6] PROGMEM = {"OK", "Up", "Down", "Left", "Right"};
+
+const menu_node lcd_ui::menu[] PROGMEM = {
+    // label      first        children  render           action       items
+    {NULL,        MENU_HOME,   4,        NULL,            NULL,        NULL},     // 0 root
+    {NULL,        0,           0,        renderHome,      NULL,        NULL},     // 1 home
+    {l_logs,      M_LOG_ENTRY, 1,        renderLogs,      NULL,        NULL},
+    {l_netstat,   0,           0,        renderNetstat,   NULL,        NULL},
+    {l_config,    M_TEMPS,     6,        NULL,            NULL,        NULL},
+    {NULL,        0,           0,        renderLogEntry,  NULL,        logItems}, // 5
+    {l_temps,     0,           0,        renderTemps,     editTemps,   NULL},     // 6
+    {l_ip,        0,           0,        NULL,            editLocalIP, NULL},
+    {l_subnet,    0,           0,        NULL,            editSubnet,  NULL},
+    {l_gateway,   0,           0,        NULL,            editGateway, NULL},
+    {l_calibrate, 0,           0,        renderCalibrate, calibrate,   NULL},
+    {l_clearlogs, 0,           0,        renderClearLogs, clearLogs,   NULL}
+};
+
+void lcd_ui::inputTask(void *ctx) {
+    lcd_ui *self = (lcd_ui*)ctx;
+    // Run everything pressed since the last poll, then update the screen
+    //  once if any of it changed it
+    button_event event;
+    bool changed = false;
+    while (self->analog.getButton(event))
+        changed |= self->editing() ? self->editableIntsInputProcess(event) :
+                self->standardMenuInputProcess(event);
+    // Calibration moving on is a change too, the screen says what's next
+    byte step = self->analog.calibrationStep();
+    if (step == five_btn::CAL_SAMPLED || step == five_btn::CAL_TIMED_OUT) {
+        self->analog.finishCalibration();
+        step = self->analog.calibrationStep();
     }
-    return false;
+    if (step != self->cal_step) {
+        self->cal_step = step;
+        changed = true;
+    }
+    if (changed)
+        self->updateScreen();
+    // Whatever the last redraw didn't get to goes out a slice per poll
+    else if (self->lcd.pending())
+        self->lcd.send(self->display, LCD_SLICE_US);
 }
 
-bool lcd_ui::editableIntsInputProcess() {
-    // Must call button down check first
-    button_event event = analog.getButton();
-
-    if (event.btn == five_btn::NO_BTN)
-        return false;
+void lcd_ui::redrawTask(void *ctx) {
+    lcd_ui *self = (lcd_ui*)ctx;
+    // We only periodically redraw screen for these conditions
+    if (self->isHomeScreen())
+        self->updateScreen();
+}
 
-    // Up and down change currently held value, uses btn press
-    if (event.btn == five_btn::UP_BTN || event.btn == five_btn::DWN_BTN) {
-        editable_ints[menu_state[2]] += (event.btn == five_btn::DWN_BTN)? -1: 1;
+bool lcd_ui::editableIntsInputProcess(const button_event &event) {
+    // Up and down change currently held value, once on the press and again
+    //  for each repeat while held, the release doesn't count
+    if ((event.btn == five_btn::UP_BTN || event.btn == five_btn::DWN_BTN) &&
+            (event.status == five_btn::ON_BUTTON_DOWN ||
+            event.status == five_btn::ON_BUTTON_HELD)) {
+        editable_ints[edit_pos] += (event.btn == five_btn::DWN_BTN)? -1: 1;
         // No need to check for out of bounds as the
         // byte itself will handle it with overflow/underflow
         return true;
@@ -60,296 +118,332 @@ bool lcd_ui::editableIntsInputProcess() {
     // On btn down we shift number held
     else if (event.status == five_btn::ON_BUTTON_DOWN &&
             (event.btn == five_btn::LFT_BTN || event.btn == five_btn::RHT_BTN)) {
-        menu_state[2] += (event.btn == five_btn::LFT_BTN)? -1: 1;;
-        // If we go too far, to the left or right, return to settings
-        if ((menu_state[2] > 3) || (menu_state[2] + 1 == 0)) {
-            editable_ints_active = false;
-            menu_state[2] = MENU_EOL;
-        }
+        edit_pos += (event.btn == five_btn::LFT_BTN)? -1: 1;
+        // If we go too far, to the left (wraps to MENU_EOL) or right,
+        //  return to settings
+        if (edit_pos > 3)
+            edit_pos = MENU_EOL;
         return true;
     }
 
-    // Last case is if we pressed the save button
+    // Last case is if we pressed the save button, the node's action saves
+    //  while editing
     else if (event.btn == five_btn::OK_BTN && event.status == five_btn::ON_BUTTON_UP) {
-        IPAddress newAddress;
-        switch (menu_state[1]) {
-            case CFG_GATEWAY:
-            case CFG_SUBNET:
-            case CFG_IP:
-                for (int i = 0; i < 4; i++)
-                    newAddress[i] = editable_ints[i];
-        }
-        switch (menu_state[1]) {
-            case CFG_GATEWAY:
-                NET.saveGatewayAddr(newAddress);
-                break;
-            case CFG_SUBNET:
-                NET.saveSubnetAddr(newAddress);
-                break;
-            case CFG_IP:
-                NET.saveLocalIPAddr(newAddress);
-                break;
-            case CFG_TEMPS:
-                DHT.setAlarmGates(editable_ints[0] - 40,
-                                    editable_ints[1] - 40,
-                                    editable_ints[2] - 40,
-                                    editable_ints[3] - 40);
-                break;
-        }
+        menu_node n;
+        readNode(node, n);
+        n.action(*this, item);
         // Return to settings
-        editable_ints_active = false;
-        menu_state[2] = MENU_EOL;
+        edit_pos = MENU_EOL;
         return true;
     }
     return false;
 }
 
-uint8_t lcd_ui::getCurrentMaxState() {
-    if (onSubMenu(SCR_LOGS))
-        return max(0, DHT.getEntriesCount() - 1);
-    else if (onSubMenu(SCR_CONFIG))
-        return CFG_CLEARLOGS;
-    else
-        return SCR_CONFIG;
+bool lcd_ui::isHomeScreen() {
+    return node == MENU_HOME && !editing();
 }
 
-bool lcd_ui::isHomeScreen() {
-    return (menu_state[0] == 0 &&
-            menu_state[1] == MENU_EOL &&
-            menu_state[2] == MENU_EOL);
-}
-
-bool lcd_ui::onSubMenu(byte menu) {
-    switch (menu) {
-        case SCR_CONFIG:
-        case SCR_LOGS:
-            return (menu_state[0] == menu &&
-                    menu_state[1] != MENU_EOL &&
-                    menu_state[2] == MENU_EOL);
-        default:
-            return false;
+void lcd_ui::readNode(uint8_t i, menu_node &n) {
+    memcpy_P(&n, &menu[i], sizeof(menu_node));
+}
+
+uint8_t lcd_ui::parentOf(uint8_t child) {
+    menu_node n;
+    for (uint8_t i = 0; i < sizeof(menu) / sizeof(menu_node); i++) {
+        readNode(i, n);
+        if (child >= n.first && child < n.first + n.children)
+            return i;
+    }
+    return MENU_ROOT;
+}
+
+void lcd_ui::enter(uint8_t i) {
+    menu_node n;
+    readNode(i, n);
+    node = i;
+    item = 0;
+    if (n.items) {
+        uint16_t count = n.items();
+        if (count)
+            item = count - 1;
     }
 }
 
 void lcd_ui::returnToHomeScreen() {
-    menu_state[0] = 0;
-    menu_state[1] = menu_state[2] = MENU_EOL;
-    menu_depth = 0;
-    editable_ints_active = false;
+    enter(MENU_HOME);
+    edit_pos = MENU_EOL;
     updateScreen();
 }
 
-bool lcd_ui::standardMenuInputProcess() {
-    button_event event = analog.getButton();
-    if (event.btn == five_btn::NO_BTN || event.status != five_btn::ON_BUTTON_UP)
+bool lcd_ui::standardMenuInputProcess(const button_event &event) {
+    if (event.status != five_btn::ON_BUTTON_UP)
         return false;
+    menu_node n;
+    readNode(node, n);
     // Normal menu navigation mode
     switch (event.btn) {
         // Go back
         case five_btn::UP_BTN:
-        returnToHomeScreen();
-        break;
+            returnToHomeScreen();
+            break;
 
-        // Cycles choices
+        // Cycles choices, the entries of a list or else the node's siblings
         case five_btn::LFT_BTN:
-            // Go back to previous (or last screen if on first)
-            if (menu_state[menu_depth] == 0)
-                menu_state[menu_depth] = getCurrentMaxState();
+        case five_btn::RHT_BTN: {
+            bool list = n.items != NULL;
+            uint16_t count;
+            uint8_t at;
+            if (list) {
+                count = n.items();
+                at = item;
+            }
+            else {
+                readNode(parentOf(node), n);
+                count = n.children;
+                at = node - n.first;
+            }
+            if (event.btn == five_btn::RHT_BTN)
+                at = at + 1u < count ? at + 1 : 0;
             else
-                menu_state[menu_depth]--;
-            break;
-        case five_btn::RHT_BTN:
-            menu_state[menu_depth]++;
-            // Have we gone past the last screen?
-            if (menu_state[menu_depth] > getCurrentMaxState())
-                menu_state[menu_depth] = 0;
+                at = at > 0 ? at - 1 : (count ? count - 1 : 0);
+            if (list)
+                item = at;
+            else
+                node = n.first + at;
             break;
+        }
 
         // Okay button is used to confirm and enter submenus
         case five_btn::OK_BTN:
-            // Confirm clear logs check
-            if (onSubMenu(SCR_CONFIG) && menu_state[1] == CFG_CLEARLOGS) {
-                if (confirm_ct >= 10)
-                    confirm_ct = 10;
-                confirm_ct--;
-                if (confirm_ct == 0)
-                    DHT.clearLog();
-            }
-            // Enter logs and config submenus check
-            else if (menu_depth == 0) {
-                if (menu_state[0] == SCR_LOGS) {
-                    menu_depth++;
-                    menu_state[1] = 0; // Needs to not be EOL for get max
-                    menu_state[1] = getCurrentMaxState();
-                }
-                else if (menu_state[0] == SCR_CONFIG) {
-                    menu_depth++;
-                    menu_state[1] = 0;
-                }
-            }
-            // All config screens but clear logs enter into edit ints mode
-            else if (menu_depth == 1 &&
-                        menu_state[0] == SCR_CONFIG &&
-                        menu_state[1] != CFG_CLEARLOGS) {
-                // Set special state flag and retrieve the data
-                editable_ints_active = true;
-                menu_state[2] = 0;
-                for (uint8_t i = 0; i < 4; i++) {
-                    switch (menu_state[1]) {
-                        case CFG_GATEWAY:
-                            editable_ints[i] = NET.gateway_addr[i];
-                            break;
-                        case CFG_IP:
-                            editable_ints[i] = NET.local_ip[i];
-                            break;
-                        case CFG_TEMPS:
-                            // Add 40 to the 16bit int we get and cast it to 8 bit
-                            // We do this because we can only show up to 255 for the
-                            // editable int screen but that is within out sensor range
-                            // anyway
-                            editable_ints[i] = (int8_t)(DHT.alarm_gates[i] + 40);
-                            break;
-                        case CFG_SUBNET:
-                            editable_ints[i] = NET.subnet_addr[i];
-                            break;
-                    }
-                }
-            }
+            if (n.action)
+                n.action(*this, item);
+            else if (n.children)
+                enter(n.first);
             break;
     }
     return true;
-    // We increment this as a psuedo reset for the confirmation dialog
-    confirm_ct++;
 }
 
 void lcd_ui::updateScreen() {
     #if DEBUG >= 2
     if ( !(isHomeScreen())) {
         Serial.print(F("Menu Change: "));
-        for(int i=0; i<3; i++) {
-            Serial.print(menu_state[i]);
-            Serial.print(' ');
-        }
-        Serial.print(F("Depth "));
-        Serial.println(menu_depth);
+        Serial.print(node);
+        Serial.print(' ');
+        Serial.print(item);
+        Serial.print(F(" Edit "));
+        Serial.println(edit_pos);
     }
     #endif
     lcd.clear();
     lcd.setCursor(0, 0);
     // Editable ints state
-    if (editable_ints_active) {
-        // menu_state[2] 0-3 determines which int we edit
-        uint8_t current_int = menu_state[2];
+    if (editing()) {
         for (int i = 0; i < 4; i++) {
-            if (i == current_int) {
+            if (i == edit_pos) {
                 lcd.setCursor(i*4, 0);
                 lcd.write(2); // up/down editable arrow
                 // Print value (-40 if temperature)
-                lcd.print((int)editable_ints[i] - (menu_state[1] == CFG_TEMPS? 40: 0));
+                lcd.print((int)editable_ints[i] - edit_offset);
                 lcd.setCursor(i*4 + 3, 1);
                 lcd.print(F(">"));
                 continue;
             }
             lcd.setCursor(i*4, 1);
             // Print value (-40 if temperature)
-            lcd.print((int)editable_ints[i] - (menu_state[1] == CFG_TEMPS? 40: 0));
+            lcd.print((int)editable_ints[i] - edit_offset);
             if (i < 3) {
-                if (i + 1 == current_int)
+                if (i + 1 == edit_pos)
                     lcd.print(F("<"));
                 else
                     lcd.print(F("."));
             }
         }
+    }
+    else {
+        menu_node n;
+        readNode(node, n);
+        if (n.label)
+            lcd.print((const __FlashStringHelper*)n.label);
+        if (n.render)
+            n.render(*this, item);
+        else if (n.children || n.action)
+            writeDownToEnter();
+        writeNextArrow();
+    }
+    lcd.send(display, LCD_SLICE_US);
+}
+
+void lcd_ui::beginEdit(int8_t offset) {
+    edit_offset = offset;
+    edit_pos = 0;
+}
+
+void lcd_ui::beginEdit(const IPAddress &addr) {
+    for (uint8_t i = 0; i < 4; i++)
+        editable_ints[i] = addr[i];
+    beginEdit(0);
+}
+
+IPAddress lcd_ui::editedAddress() {
+    return IPAddress(editable_ints[0], editable_ints[1],
+            editable_ints[2], editable_ints[3]);
+}
+
+// ====== //
+// Menu table entries
 
+void lcd_ui::renderHome(lcd_ui &ui, uint8_t) {
+    ui.writeTempHum_to_LCD(DHT.temperature, DHT.humidity);
+    ui.lcd.setCursor(11, 1); // 11 = 16 - len("12:59")
+    ui.writeTime_to_LCD(RTC.readTime());
+}
+
+// Columns an int takes printed
+static uint8_t printedWidth(int16_t n) {
+    uint8_t width = n < 0 ? 2 : 1;
+    for (n /= 10; n; n /= 10)
+        width++;
+    return width;
+}
+
+void lcd_ui::renderLogs(lcd_ui &ui, uint8_t) {
+    // Temperature range since the log was cleared, up to "-40-176", right
+    //  aligned short of the arrow where the short title leaves it room
+    const log_stats &stats = DHT.getLogStats();
+    if (stats.count) {
+        int16_t low = roundTenths(DHT.toFahrenheit(stats.temp_min * 10));
+        int16_t high = roundTenths(DHT.toFahrenheit(stats.temp_max * 10));
+        ui.lcd.setCursor(13 - printedWidth(low) - printedWidth(high), 0);
+        ui.lcd.print(low);
+        ui.lcd.print(F("-"));
+        ui.lcd.print(high);
     }
-    // Check for sub menus
-    else if (onSubMenu(SCR_LOGS)) {
-        if (getCurrentMaxState() == 0) {
-            lcd.print(F("No logs."));
-        }
-        else {
-            lcd.write(0x7F); // Left arrow
-            lcd.setCursor(5, 0);
-            log_entry entry = DHT.getLogEntry(menu_state[1]);
-            writeTime_to_LCD(entry.ts);
-            writeNextArrow();
-            lcd.setCursor(0, 1);
-            lcd.print(menu_state[1] + 1);
-            lcd.print(F(":"));
-            lcd.setCursor(4, 1);
-            writeTempHum_to_LCD(entry.temp, entry.humid);
-        }
+    // The count fits before the prompt, a full log is a few hundred
+    ui.lcd.setCursor(0, 1);
+    ui.lcd.print(DHT.getEntriesCount());
+    ui.writeDownToEnter();
+}
+
+uint16_t lcd_ui::logItems() {
+    // Entries are byte indexed, so only the newest 256 logs can be browsed
+    return min(DHT.getEntriesCount(), 256u);
+}
+
+void lcd_ui::renderLogEntry(lcd_ui &ui, uint8_t item) {
+    if (logItems() == 0) {
+        ui.lcd.print(F("No logs."));
+        return;
     }
-    else if (onSubMenu(SCR_CONFIG)) {
-        switch (menu_state[1]) {
-            case CFG_CLEARLOGS:
-                lcd.print(F("Clear Logs?"));
-                if (confirm_ct < 10) {
-                    lcd.setCursor(11, 0);
-                    lcd.print("...");
-                    lcd.print(confirm_ct);
-                }
-                lcd.setCursor(0, 1);
-                if (confirm_ct <= 0)
-                    lcd.print(F("  Cleared!"));
-                else
-                    lcd.print(F("Push X to clear"));
-                break;
-            case CFG_IP:
-                lcd.print(F("Change IP Addr"));
-                writeDownToEnter();
-                break;
-            case CFG_TEMPS:
-                lcd.print(F("Temp. Alarm"));
-                lcd.setCursor(0,1);
-                lcd.print(F("Gates"));
-                writeDownToEnter();
-                break;
-            case CFG_SUBNET:
-                lcd.print(F("Config Subnet"));
-                writeDownToEnter();
-                break;
-            case CFG_GATEWAY:
-                lcd.print(F("Config Gateway"));
-                writeDownToEnter();
-                break;
-        }
-        writeNextArrow();
+    ui.lcd.write(0x7F); // Left arrow
+    ui.lcd.setCursor(5, 0);
+    uint16_t count = DHT.getEntriesCount();
+    uint16_t i = (count > 256 ? count - 256 : 0) + item;
+    log_entry entry = DHT.getLogEntry(i);
+    ui.writeTime_to_LCD(entry.ts);
+    ui.lcd.setCursor(0, 1);
+    ui.lcd.print(i + 1);
+    ui.lcd.print(F(":"));
+    ui.lcd.setCursor(4, 1);
+    ui.writeTempHum_to_LCD(entry.temp, entry.humid);
+}
+
+void lcd_ui::renderNetstat(lcd_ui &ui, uint8_t) {
+    ui.lcd.setCursor(0, 1);
+    ui.lcd.print(F("Snt:"));
+    ui.lcd.print(NET.packetsSent);
+    ui.lcd.print(F(" Rcv:"));
+    ui.lcd.print(NET.packetsRcvd);
+}
+
+void lcd_ui::renderTemps(lcd_ui &ui, uint8_t) {
+    ui.lcd.setCursor(0,1);
+    ui.lcd.print(F("Gates"));
+    ui.writeDownToEnter();
+}
+
+void lcd_ui::renderClearLogs(lcd_ui &ui, uint8_t) {
+    if (ui.confirm_ct < 10) {
+        ui.lcd.setCursor(11, 0);
+        ui.lcd.print("...");
+        ui.lcd.print(ui.confirm_ct);
     }
-    // Top level menus
-    else {
-        switch (menu_state[0]) {
-            case SCR_DHT:
-                writeTempHum_to_LCD(DHT.temperature, DHT.humidity);
-                lcd.setCursor(11, 1); // 11 = 16 - len("12:59")
-                writeTime_to_LCD(RTC.readTime());
-                break;
-            case SCR_LOGS:
-                lcd.print(F("DHT Logs"));
-                writeDownToEnter();
-                break;
-            case SCR_NETSTAT:
-                lcd.print(F("Ntwrk Packets"));
-                lcd.setCursor(0, 1);
-                lcd.print(F("Snt:"));
-                lcd.print(NET.packetsSent);
-                lcd.print(F(" Rcv:"));
-                lcd.print(NET.packetsRcvd);
-                break;
-            case SCR_CONFIG:
-                lcd.print(F("Config"));
-                writeDownToEnter();
-                break;
-        }
-        writeNextArrow();
+    ui.lcd.setCursor(0, 1);
+    if (ui.confirm_ct <= 0)
+        ui.lcd.print(F("  Cleared!"));
+    else
+        ui.lcd.print(F("Push X to clear"));
+}
+
+void lcd_ui::renderCalibrate(lcd_ui &ui, uint8_t) {
+    ui.lcd.setCursor(0, 1);
+    if (ui.cal_step >= 1 && ui.cal_step <= CONFIG_BUTTONS) {
+        ui.lcd.print(F("Press "));
+        ui.lcd.print((const __FlashStringHelper*)cal_names[ui.cal_step - 1]);
     }
+    else if (ui.cal_step == five_btn::CAL_SAVED)
+        ui.lcd.print(F("Saved"));
+    else if (ui.cal_step == five_btn::CAL_FAILED)
+        ui.lcd.print(F("Failed, kept old"));
+    else
+        ui.writeDownToEnter();
+}
+
+void lcd_ui::calibrate(lcd_ui &ui, uint8_t) {
+    ui.analog.calibrate();
+}
+
+void lcd_ui::editTemps(lcd_ui &ui, uint8_t) {
+    if (ui.editing()) {
+        DHT.setAlarmGates(ui.editable_ints[0] - 40,
+                            ui.editable_ints[1] - 40,
+                            ui.editable_ints[2] - 40,
+                            ui.editable_ints[3] - 40);
+        return;
+    }
+    // Add 40 to the 16bit int we get and cast it to 8 bit
+    // We do this because we can only show up to 255 for the
+    // editable int screen but that is within out sensor range
+    // anyway
+    for (uint8_t i = 0; i < 4; i++)
+        ui.editable_ints[i] = (int8_t)(DHT.alarm_gates[i] + 40);
+    ui.beginEdit(40);
+}
+
+void lcd_ui::editLocalIP(lcd_ui &ui, uint8_t) {
+    if (ui.editing())
+        NET.saveLocalIPAddr(ui.editedAddress());
+    else
+        ui.beginEdit(NET.local_ip);
+}
+
+void lcd_ui::editSubnet(lcd_ui &ui, uint8_t) {
+    if (ui.editing())
+        NET.saveSubnetAddr(ui.editedAddress());
+    else
+        ui.beginEdit(NET.subnet_addr);
+}
+
+void lcd_ui::editGateway(lcd_ui &ui, uint8_t) {
+    if (ui.editing())
+        NET.saveGatewayAddr(ui.editedAddress());
+    else
+        ui.beginEdit(NET.gateway_addr);
+}
+
+void lcd_ui::clearLogs(lcd_ui &ui, uint8_t) {
+    if (ui.confirm_ct >= 10)
+        ui.confirm_ct = 10;
+    ui.confirm_ct--;
+    if (ui.confirm_ct == 0)
+        DHT.clearLog();
 }
 
-void lcd_ui::writeTempHum_to_LCD(float temp, uint8_t humid) {
-    lcd.print(DHT.toFahrenheit(temp));
+void lcd_ui::writeTempHum_to_LCD(int16_t temp, int16_t humid) {
+    lcd.print(roundTenths(DHT.toFahrenheit(temp)));
     lcd.write(0xDF); // Degree symbol
     lcd.print(F("F, "));
-    lcd.print((int)humid);
+    lcd.print(roundTenths(humid));
     lcd.print(F("%RH"));
 }
 
@@ -8,21 +8,35 @@
 #include <LiquidCrystal.h>
 #include "token_definitions.h"
 #include "fivebtn_analog.h"
+#include "lcd_buffer.h"
 #include "rtc_control.h"
 #include "dht_control.h"
+#include "scheduler.h"
+#include "config_store.h"
 
 #define MENU_EOL 255
-
-#define SCR_DHT 0
-#define SCR_LOGS 1
-#define SCR_NETSTAT 2
-#define SCR_CONFIG 3
-
-#define CFG_TEMPS 0
-#define CFG_IP 1
-#define CFG_SUBNET 2
-#define CFG_GATEWAY 3
-#define CFG_CLEARLOGS 4
+#define MENU_ROOT 0
+#define MENU_HOME 1
+
+class lcd_ui;
+
+// Draws a node's screen, or runs its OK action. The second argument is the
+//  entry shown when the node is a list.
+typedef void (*menu_fn)(lcd_ui&, uint8_t);
+// Number of entries in a list node
+typedef uint16_t (*menu_count_fn)();
+
+// One screen of the menu, the whole tree is a table in flash. Children
+//  are consecutive rows, Left and Right cycle through them and Up always
+//  goes home.
+struct menu_node {
+    const char *label;      // Flash string drawn top left, or NULL
+    uint8_t first;          // Row of the first child
+    uint8_t children;
+    menu_fn render;         // Draws after the label, NULL for "X to enter"
+    menu_fn action;         // OK on the node, NULL enters the first child
+    menu_count_fn items;    // Makes the node a list of this many entries
+};
 
 #define RS_PIN 7
 #define EN_PIN 6
@@ -34,21 +48,56 @@
 class lcd_ui
 {
     private:
-        LiquidCrystal lcd = LiquidCrystal(RS_PIN, EN_PIN, D4_PIN, D5_PIN, D6_PIN, D7_PIN);
+        LiquidCrystal display = LiquidCrystal(RS_PIN, EN_PIN, D4_PIN, D5_PIN, D6_PIN, D7_PIN);
+        // Everything draws here, the differences go out a slice at a time
+        lcd_buffer lcd;
         five_btn analog;
-        uint8_t menu_state[3] = {0, MENU_EOL, MENU_EOL};
+        uint8_t node = MENU_HOME;    // Row of the menu table shown
+        uint8_t item = 0;            // Entry shown when node is a list
         uint8_t editable_ints[4];
-        uint8_t menu_depth = 0;
+        uint8_t edit_pos = MENU_EOL; // Int being edited, MENU_EOL if none
+        int8_t edit_offset = 0;      // Subtracted from the ints when shown
         uint8_t confirm_ct = 100;
-        bool editable_ints_active = false;
+        byte cal_step = five_btn::CAL_IDLE; // Calibration step on screen
+
+        static const menu_node menu[];
+
+        // Scheduled every BUTTON_POLL_DELAY and SCREEN_UPDATE_DELAY
+        static void inputTask(void*);
+        static void redrawTask(void*);
+
+        static void readNode(uint8_t, menu_node&);
+        // Row of the node the given one is a child of
+        static uint8_t parentOf(uint8_t);
+        // Show a node, lists start on their newest entry
+        void enter(uint8_t);
+
+        bool editing() { return edit_pos != MENU_EOL; }
+        // Start editing editable_ints, shown less the offset
+        void beginEdit(int8_t);
+        void beginEdit(const IPAddress&);
+        IPAddress editedAddress();
+
+        // Renderers, actions and list sizes for the menu table
+        static void renderHome(lcd_ui&, uint8_t);
+        static void renderLogs(lcd_ui&, uint8_t);
+        static void renderLogEntry(lcd_ui&, uint8_t);
+        static void renderNetstat(lcd_ui&, uint8_t);
+        static void renderTemps(lcd_ui&, uint8_t);
+        static void renderCalibrate(lcd_ui&, uint8_t);
+        static void renderClearLogs(lcd_ui&, uint8_t);
+        // OK starts an edit, OK in the editor calls them again to save it
+        static void editTemps(lcd_ui&, uint8_t);
+        static void editLocalIP(lcd_ui&, uint8_t);
+        static void editSubnet(lcd_ui&, uint8_t);
+        static void editGateway(lcd_ui&, uint8_t);
+        static void calibrate(lcd_ui&, uint8_t);
+        static void clearLogs(lcd_ui&, uint8_t);
+        static uint16_t logItems();
     public:
-        // Arduino Setup Call
+        // Arduino Setup Call, registers the input and redraw tasks
         void setup();
 
-        // Arduino Loop Call
-        // Return true if token buffer needs to be processed
-        bool loop();
-
         // Process analog input for editable ints state
         /* The editable ints state stores 4 byte sized ints into the
                 editable ints variable. The retrive/edit/saving is handled in this
@@ -56,30 +105,27 @@ class lcd_ui
             Temperature int's are retrieved and saved with a +-40 offset to contain it
                 within the byte (DHT22 min of -40 max of 177 F) and also printed
                 with this offset in mind. e.g. (0 is -40, 217 is 177)*/
-        bool editableIntsInputProcess();
-
-        // Return max menu index depending on flags
-        // Scrolling of the menu state does have a max of MENU_EOL (255)
-        uint8_t getCurrentMaxState();
+        bool editableIntsInputProcess(const button_event&);
 
         // Return true if menu state is home screen
         bool isHomeScreen();
 
-        // checks if menu state is currently set to
-        //  scrollable of the given menu
-        bool onSubMenu(byte);
-
-        // Update screen using current values
+        // Redraw the screen from current values and start sending what changed
         void updateScreen();
 
+        // Button events taken, dropped and how long they waited
+        void printInputStats(Print &Printer) { analog.printStats(Printer); }
+
         // Go back to home screen
         void returnToHomeScreen();
 
-        // Process analog input for standard menu situation
-        bool standardMenuInputProcess();
+        // Process analog input for standard menu situation, navigates the
+        //  menu table
+        bool standardMenuInputProcess(const button_event&);
 
-        // Write given object to the LCD screen at current position
-        void writeTempHum_to_LCD(float, uint8_t);
+        // Write given object to the LCD screen at current position,
+        //  temperature and humidity in tenths shown to the nearest whole
+        void writeTempHum_to_LCD(int16_t, int16_t);
         void writeTime_to_LCD(DateTime);
 
         // Write common things to the LCd screen in specific spots
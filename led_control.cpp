@@ -4,10 +4,27 @@
 #define DEBUG 0
 
 #define RGB_DEFAULT_LIGHT 0
+#define NO_CHANGE 0xFFFF
 
 // Out is used for any outward output in response to a function call
 // and will ouput to serial or udp depending on Output's setting
 extern Output out;
+extern task_scheduler TASKS;
+
+// Rising half of a breath, (1 - cos) / 2 with a 2.2 gamma so it looks even
+const uint8_t breathe_lut[LED_BREATHE_STEPS / 2] PROGMEM = {
+    0, 0, 0, 0, 0, 1, 1, 2, 4, 7, 11, 15, 22, 29, 39, 50,
+    62, 76, 91, 107, 124, 141, 159, 176, 192, 207, 221, 233, 242, 249, 254, 255
+};
+
+static bool animated(byte state) {
+    return state == t_BLINK || state == LED_BREATHE || state == LED_CYCLE;
+}
+
+const uint8_t led_palettes[][LED_PALETTE_SIZE][3] PROGMEM = {
+    {{100, 0, 0}, {60, 20, 0}, {100, 0, 0}, {0, 0, 0}},   // LED_PALETTE_HOT
+    {{40, 0, 40}, {0, 0, 50}, {40, 0, 40}, {0, 0, 0}}     // LED_PALETTE_COLD
+};
 
 void led_control::setup() {
     blink_rate = 500;
@@ -17,58 +34,135 @@ void led_control::setup() {
         leds[i] = CRGB::Black;
         leds_mem[i] = CRGB::Blue;
     }
-    FastLED.show();
+    requests++;
+    dirty = true;
+    effect_task = TASKS.add(F("led"), effectTask, this, 0);
+    TASKS.stop(effect_task);
 }
 
-void led_control::loop() {
-    bool check_for_blink = false;
+void led_control::effectTask(void *ctx) {
+    led_control *self = (led_control*)ctx;
+    self->advanceEffects(millis());
+    uint16_t next = NO_CHANGE;
     for (uint8_t i=0; i < NUM_LEDS; i++) {
-        if (led_states[i] == t_BLINK) {
-            check_for_blink = true;
+        if (!animated(self->led_states[i]))
+            continue;
+        uint16_t wait = self->renderEffect(i);
+        next = min(next, wait);
+    }
+    if (next != NO_CHANGE)
+        TASKS.wake(self->effect_task, next);
+}
+
+void led_control::restartEffects() {
+    TASKS.wake(effect_task, 0);
+}
+
+void led_control::advanceEffects(uint32_t now) {
+    // Each light is moved at least once a period, so this stays well short
+    //  of wrapping for any that are animated
+    uint32_t elapsed = now - effects_at;
+    effects_at = now;
+    for (uint8_t i=0; i < NUM_LEDS; i++) {
+        if (!animated(led_states[i]))
+            continue;
+        led_effect &fx = effects[i];
+        fx.pos = ((uint32_t)fx.pos + elapsed % fx.period) % fx.period;
+    }
+}
+
+uint16_t led_control::renderEffect(uint8_t light) {
+    const led_effect &fx = effects[light];
+    uint16_t pos = ((uint32_t)fx.pos + fx.phase) % fx.period;
+    // Index into the effect's steps and where the next step starts
+    uint8_t steps, step;
+    switch (led_states[light]) {
+        case t_BLINK:
+            steps = 2;
             break;
-        }
+        case LED_BREATHE:
+            steps = LED_BREATHE_STEPS;
+            break;
+        default:
+            steps = LED_PALETTE_SIZE;
     }
-    if (check_for_blink) {
-        // Divide millis into "number of blink_rates that have passed"
-        // Then set light based on odd or even
-        // If flag is on and we are on an even iterval
-        //      or if flag is off and we are on an odd we run toggle
-        if ((blink_flag && ((millis() / blink_rate) % 2 == 0)) ||
-            (!blink_flag && ((millis() / blink_rate) % 2 == 1)) ) {
-            blink_flag = !blink_flag;
-            for (uint8_t i=0; i < NUM_LEDS; i++) {
-                if (led_states[i] == t_BLINK)
-                    toggleLight(i);
-            }
-        }
+    step = (uint32_t)pos * steps / fx.period;
+    uint16_t end = ((uint32_t)(step + 1) * fx.period + steps - 1) / steps;
+
+    CRGB color = leds_mem[light];
+    if (led_states[light] == t_BLINK) {
+        if (step)
+            color = CRGB::Black;
+    }
+    else if (led_states[light] == LED_BREATHE) {
+        if (step >= LED_BREATHE_STEPS / 2)
+            step = LED_BREATHE_STEPS - 1 - step;
+        uint16_t level = pgm_read_byte(&breathe_lut[step]) + 1;
+        for (uint8_t c = 0; c < 3; c++)
+            color.raw[c] = (color.raw[c] * level) >> 8;
     }
+    else {
+        for (uint8_t c = 0; c < 3; c++)
+            color.raw[c] = pgm_read_byte(&led_palettes[fx.palette][step][c]);
+    }
+    setPixel(light, color);
+    return end - pos;
 }
 
 void led_control::printStatus() {
-    for (uint8_t i=0; i < NUM_LEDS; i++) {
-        out.print(F("Light "));
-        out.print(i);
-        out.print(" set to ");
-        switch (led_states[i]) {
-            case t_ON:
-                out.print(F("on"));
-                break;
-            case t_OFF:
-                out.print(F("off"));
-                break;
-            case t_BLINK:
-                out.print(F("blink"));
-        }
-        out.print(F(", color is rgb("));
-        out.print(leds[i].red);
-        out.print(F(", "));
-        out.print(leds[i].green);
-        out.print(F(", "));
-        out.print(leds[i].blue);
-        out.println(F(")"));
+    for (uint8_t n = 0; printStatusLine(n); n++)
+        ;
+}
+
+bool led_control::printStatusLine(uint8_t i) {
+    if (i == NUM_LEDS) {
+        out.print(F("Blink Rate: "));
+        out.println(blink_rate);
+        return true;
+    }
+    if (i == NUM_LEDS + 1) {
+        out.print(F("Shows: "));
+        out.print(shows);
+        out.print(F(", avoided "));
+        out.println(requests - shows);
+        return true;
     }
-    out.print(F("Blink Rate: "));
-    out.println(blink_rate);
+    if (i > NUM_LEDS + 1)
+        return false;
+    out.print(F("Light "));
+    out.print(i);
+    out.print(" set to ");
+    switch (led_states[i]) {
+        case t_ON:
+            out.print(F("on"));
+            break;
+        case t_OFF:
+            out.print(F("off"));
+            break;
+        case t_BLINK:
+            out.print(F("blink"));
+            break;
+        case LED_BREATHE:
+            out.print(F("breathe"));
+            break;
+        case LED_CYCLE:
+            out.print(F("cycle "));
+            out.print(effects[i].palette);
+    }
+    if (led_states[i] != t_ON && led_states[i] != t_OFF) {
+        out.print(F(" every "));
+        out.print(effects[i].period);
+        out.print(F("ms +"));
+        out.print(effects[i].phase);
+    }
+    out.print(F(", color is rgb("));
+    out.print(leds[i].red);
+    out.print(F(", "));
+    out.print(leds[i].green);
+    out.print(F(", "));
+    out.print(leds[i].blue);
+    out.println(F(")"));
+    return true;
 }
 
 void led_control::setBlinkRate(word w) {
@@ -76,7 +170,10 @@ void led_control::setBlinkRate(word w) {
     Serial.print(F("LED.setBlinkRate "));
     Serial.println(w);
     #endif
-    blink_rate = w;
+    blink_rate = max(w, (word)1);
+    for (uint8_t i=0; i < NUM_LEDS; i++)
+        if (led_states[i] == t_BLINK && effects[i].shared)
+            setLightStatus(i, t_BLINK);
 }
 
 void led_control::setLightStatus(byte b) {
@@ -93,13 +190,49 @@ void led_control::setLightStatus(uint8_t light, byte b) {
         out.println(F("Invalid light value"));
         return;
     }
+    if (b == t_BLINK) {
+        // The rate is how long it stays on or off
+        setEffect(light, t_BLINK, min(blink_rate, 32767u) * 2, 0);
+        effects[light].shared = true;
+        return;
+    }
     led_states[light] = b;
-    if (b == t_ON || b == t_OFF) {
-        // Set color to either prev color or black/off
-        leds[light] = (led_states[light] == t_ON)? leds_mem[light]: CRGB::Black;
-        FastLED.show();
+    // Set color to either prev color or black/off
+    setPixel(light, (led_states[light] == t_ON)? leds_mem[light]: CRGB::Black);
+}
+
+void led_control::setEffect(uint8_t light, byte mode, word period, word phase) {
+    if (light >= NUM_LEDS) {
+        out.println(F("Invalid light value"));
+        return;
     }
-    // Blink state will be handled in loop calls and only needs the state set
+    // Below a ms per step the next change would always be now
+    uint8_t steps = mode == LED_BREATHE ? LED_BREATHE_STEPS :
+            mode == LED_CYCLE ? LED_PALETTE_SIZE : 2;
+    period = max(period, (word)steps);
+    // Join a light already on this period, this one included, so setting
+    //  the same effect again doesn't restart it
+    advanceEffects(millis());
+    uint16_t pos = 0;
+    for (uint8_t i=0; i < NUM_LEDS; i++)
+        if (animated(led_states[i]) && effects[i].period == period) {
+            pos = effects[i].pos;
+            break;
+        }
+    led_states[light] = mode;
+    effects[light].shared = false;
+    effects[light].period = period;
+    effects[light].phase = phase % period;
+    effects[light].pos = pos;
+    restartEffects();
+}
+
+void led_control::setCycle(uint8_t light, uint8_t palette, word period) {
+    if (palette >= sizeof(led_palettes) / sizeof(led_palettes[0]))
+        return;
+    if (light < NUM_LEDS)
+        effects[light].palette = palette;
+    setEffect(light, LED_CYCLE, period, 0);
 }
 
 void led_control::setRGBColor(byte r, byte g, byte b) {
@@ -107,34 +240,32 @@ void led_control::setRGBColor(byte r, byte g, byte b) {
 }
 
 void led_control::setRGBColor(uint8_t light, byte r, byte g, byte b) {
-    leds[light] = CRGB(r, g, b);
-    leds_mem[light] = leds[light];
-    if (led_states[light] != t_BLINK)
+    leds_mem[light] = CRGB(r, g, b);
+    // Animated lights pick the color up at their next step
+    if (led_states[light] == t_ON || led_states[light] == t_OFF) {
+        setPixel(light, leds_mem[light]);
         led_states[light] = (r+g+b > 1)? t_ON: t_OFF;
-    FastLED.show();
+    }
+    else
+        restartEffects();
+}
+
+void led_control::setPixel(uint8_t light, const CRGB &color) {
+    requests++;
+    if (leds[light] == color)
+        return;
+    leds[light] = color;
+    dirty = true;
 }
 
-void led_control::toggleLight(uint8_t light) {
+void led_control::show() {
+    if (!dirty)
+        return;
     #if DEBUG >= 2
-    Serial.print(F("LED.toggle "));
-    Serial.println(light);
+    Serial.print(F("LED.show, avoided "));
+    Serial.println(requests - shows);
     #endif
-    if (light >= NUM_LEDS) {
-        out.println(F("Invalid light value"));
-        return;
-    }
-    switch (led_states[light]) {
-        case t_ON:
-            leds[light] = CRGB::Black;
-            led_states[light] = t_OFF;
-            break;
-        case t_OFF:
-            leds[light] = leds_mem[light];
-            led_states[light] = t_ON;
-            break;
-        case t_BLINK:
-            bool is_on = leds[light] == leds_mem[light];
-            leds[light] = is_on? CRGB::Black: leds_mem[light];
-    }
     FastLED.show();
+    dirty = false;
+    shows++;
 }
\ No newline at end of file
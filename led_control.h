@@ -1,36 +1,85 @@
 // led_control.h
-/* Class to control the LEDs on the Arduino board. */
+/* Class to control the LEDs on the Arduino board.
+    Changes only mark the strip dirty, show() sends it once per loop. The
+        WS2812 wire protocol runs with interrupts off for the whole strip,
+        so a blink tick or an alarm change that sets the color and then the
+        status would otherwise send the same frame several times over, and
+        serial bytes arriving meanwhile can be lost.
+    Each light runs its own effect with its own period and phase. Where
+        each is in its cycle is carried forward by the time elapsed rather
+        than worked out from millis() itself, whose wrap isn't a whole
+        number of periods. A light given the period of one already running
+        starts in step with it. The effect task sleeps until the soonest
+        light changes next and stops when none are animated. */
 #ifndef LED_H
 #define LED_H
 
 #include <Arduino.h>
 #include <FastLED.h>
 #include "output.h"
+#include "scheduler.h"
 #include "token_definitions.h"
 
 //FastLED
 #define NUM_LEDS 4
 #define DATA_PIN 9
 
+// Light modes past the t_ON, t_OFF and t_BLINK tokens
+#define LED_BREATHE 64      // Fades the color in and out
+#define LED_CYCLE 65        // Steps through a palette
+
+// Palettes for LED_CYCLE, LED_PALETTE_SIZE colors each
+#define LED_PALETTE_SIZE 4
+#define LED_PALETTE_HOT 0
+#define LED_PALETTE_COLD 1
+
+#define LED_BREATHE_STEPS 64 // Per period, up the LUT and back down
+
+struct led_effect {
+    uint16_t period;    // ms for one whole cycle
+    uint16_t phase;     // ms it runs ahead of lights in step with it
+    uint16_t pos;       // ms into the cycle at effects_at, before phase
+    uint8_t palette;    // LED_CYCLE only
+    bool shared;        // Blinks at blink_rate, see setBlinkRate()
+};
+
 class led_control
 {
     private:
         CRGB leds[NUM_LEDS];
         CRGB leds_mem[NUM_LEDS];
         byte led_states[NUM_LEDS];
+        led_effect effects[NUM_LEDS];
         word blink_rate = 500;
-        bool blink_flag = false;
+        uint8_t effect_task = TASK_NONE;
+        uint32_t effects_at = 0; // millis() the effects' pos is for
+        bool dirty = false;     // leds differ from what was last sent
+        uint32_t requests = 0;  // Changes that each used to send the strip
+        uint32_t shows = 0;     // Times it was actually sent
+
+        // One-shot, woken at the next change of any animated light
+        static void effectTask(void*);
+        // Work the effect out again now, on the next pass of the loop
+        void restartEffects();
+        // Move every animated light's pos on to the given time
+        void advanceEffects(uint32_t);
+        // Set an animated light's color for its pos, returns the ms until
+        //  it changes again
+        uint16_t renderEffect(uint8_t);
+        // Set a light's color, marks the strip dirty if it changes
+        void setPixel(uint8_t, const CRGB&);
     public:
-        // Arduino setup calls
+        // Arduino setup calls, registers the effect task
         void setup();
 
-        // Called in arduino's loop. Mostly handles blinks
-        void loop();
-
         // Print current status of all lights
         void printStatus();
+        // Print line n of it, one per light then the blink rate and the
+        //  shows avoided. Returns false once past the last line
+        bool printStatusLine(uint8_t);
 
-        // Adjust blink rate of all lights
+        // Adjust blink rate of the lights set to blink by status, those
+        //  given their own period by setEffect() keep it
         void setBlinkRate(word);
 
         // Sets a light's status. Options are on, off, blink.
@@ -38,13 +87,18 @@ class led_control
         // Sets the default adjustable light
         void setLightStatus(byte);
 
+        // Animate a light, t_BLINK or LED_BREATHE in its current color or
+        //  LED_CYCLE through its palette, with the period and phase in ms
+        void setEffect(uint8_t, byte, word, word);
+        // Step a light through a palette over the period in ms
+        void setCycle(uint8_t, uint8_t, word);
+
         // Sets RGB light to a specific color value
         void setRGBColor(byte, byte, byte);
         void setRGBColor(uint8_t, byte, byte, byte);
 
-        // A mostly internal function that simply flips the light
-        //      for the blinking status
-        void toggleLight(byte);
+        // Send the strip if anything changed, called once per loop
+        void show();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -6,32 +6,22 @@
 
 #define CS_PIN 10
 #define UDP_DELAY 5000
-#define NETWORK_SAVE_START 247
 #define RGB_NETWORK_CONNECTED_LIGHT 3
-// EEPROM saved from 247 through 272
-/*  dest_ip ..... 6
-    dest_port ... 2
-    local_ip .... 6
-    subnet_ip ... 6
-    gateway ..... 6
-*/
 
 // Used to toggle network connected / not connected
 extern led_control LED;
+extern task_scheduler TASKS;
+extern config_store CONFIG;
 
 void network_control::setup() {
     Ethernet.init(CS_PIN);
 
-    // Check for saved destination ip:port
-    EEPROM.get(NETWORK_SAVE_START, dest_ip);
-    EEPROM.get(NETWORK_SAVE_START + sizeof(IPAddress), dest_port);
-    // Check for subnet and gateway
-    EEPROM.get(NETWORK_SAVE_START + sizeof(IPAddress) + sizeof(int),
-            local_ip);
-    EEPROM.get(NETWORK_SAVE_START + 2*sizeof(IPAddress) + sizeof(int),
-            subnet_addr);
-    EEPROM.get(NETWORK_SAVE_START + 3*sizeof(IPAddress) + sizeof(int),
-            gateway_addr);
+    // Saved addresses, CONFIG was loaded before any module's setup
+    dest_ip = toIPAddress(CONFIG.data.dest_ip);
+    dest_port = CONFIG.data.dest_port;
+    local_ip = toIPAddress(CONFIG.data.local_ip);
+    subnet_addr = toIPAddress(CONFIG.data.subnet);
+    gateway_addr = toIPAddress(CONFIG.data.gateway);
     #if DEBUG >= 1
     Serial.print(F("Dest IP and Port pulled from EEPROM: "));
     for (int i=0; i < 4; i++) {
@@ -70,16 +60,15 @@ void network_control::setup() {
 
     Ethernet.begin(mac_address, local_ip);
     active = false;
-    // Connection will start in loop call
+    // Connection will start in the first link task run
+    link_task = TASKS.add(F("link"), linkTask, this, UDP_DELAY);
 }
 
-bool network_control::loop() {
-    // Check timer
-    if (millis() - timer < 0)
-        return false;
-    
-    timer = millis() + UDP_DELAY;
+void network_control::linkTask(void *ctx) {
+    ((network_control*)ctx)->checkLink();
+}
 
+void network_control::checkLink() {
     if (active && Ethernet.linkStatus() == LinkOFF) {
         // Cable disconnected?
         active = false;
@@ -94,10 +83,12 @@ bool network_control::loop() {
         }
         else {
             // Wait longer to check again
-            timer = millis() + UDP_DELAY * 10;
+            TASKS.wake(link_task, UDP_DELAY * 10);
         }
     }
+}
 
+bool network_control::receive() {
     if (!active) return false;
 
     // if there's data available, read a packet
@@ -194,16 +185,20 @@ void network_control::setNetworkLight(bool on) {
     LED.setRGBColor(RGB_NETWORK_CONNECTED_LIGHT, on? 0: 50, on? 50: 0, 0);
 }
 
-// EEPROM saving functions
-/*  dest_ip ..... 6
-    dest_port ... 1
-    local_ip .... 6
-    subnet_ip ... 6
-    gateway ..... 6
-*/
+IPAddress network_control::toIPAddress(const uint8_t *b) {
+    return IPAddress(b[0], b[1], b[2], b[3]);
+}
+
+void network_control::saveIPAddress(uint8_t *b, const IPAddress &ip) {
+    for (uint8_t i = 0; i < 4; i++)
+        b[i] = ip[i];
+}
+
+// EEPROM saving functions, each writes back the config block
 void network_control::saveDestAddrPort(IPAddress ip, unsigned int port) {
-    EEPROM.put(NETWORK_SAVE_START, ip);
-    EEPROM.put(NETWORK_SAVE_START + sizeof(IPAddress), port);
+    saveIPAddress(CONFIG.data.dest_ip, ip);
+    CONFIG.data.dest_port = port;
+    CONFIG.save();
     dest_ip = ip;
     dest_port = port;
     #if DEBUG >= 2
@@ -219,15 +214,18 @@ void network_control::saveDestAddrPort(IPAddress ip, unsigned int port) {
     #endif
 }
 void network_control::saveLocalIPAddr(IPAddress ip) {
-    EEPROM.put(NETWORK_SAVE_START + sizeof(IPAddress) + sizeof(int), ip);
+    saveIPAddress(CONFIG.data.local_ip, ip);
+    CONFIG.save();
     local_ip = ip;
     // Do we need to close connection and restart...?
 }
 void network_control::saveSubnetAddr(IPAddress ip) {
-    EEPROM.put(NETWORK_SAVE_START + 2*sizeof(IPAddress) + sizeof(int), ip);
+    saveIPAddress(CONFIG.data.subnet, ip);
+    CONFIG.save();
     subnet_addr = ip;
 }
 void network_control::saveGatewayAddr(IPAddress ip) {
-    EEPROM.put(NETWORK_SAVE_START + 3*sizeof(IPAddress) + sizeof(int), ip);
+    saveIPAddress(CONFIG.data.gateway, ip);
+    CONFIG.save();
     gateway_addr = ip;
 }
\ No newline at end of file
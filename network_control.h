@@ -5,37 +5,47 @@
 
 #include <Arduino.h>
 #include <Ethernet.h>
-#include <EEPROM.h>
+#include "config_store.h"
+#include "scheduler.h"
 #include "token_definitions.h"
 
 class network_control
 {
     private:
-        unsigned long timer;
+        uint8_t link_task = TASK_NONE;
         byte mac_address[6] = {0xAA, 0x2B, 0xCC, 0x4D, 0xEE, 0x6F};
-        IPAddress dest_ip{192, 168, 1, 1}; // Dest IP and port gets overwritten by first contact
+        IPAddress dest_ip; // Dest IP and port gets overwritten by first contact
         unsigned int local_port = 8888;
-        unsigned int dest_port = 8888;
+        unsigned int dest_port;
         unsigned int packetBufferSize;
         char packetBuffer[UDP_TX_PACKET_MAX_SIZE];
         bool active = true;
         bool dest_set = false;
+
+        // Scheduled every UDP_DELAY, watches the cable and (re)connects
+        static void linkTask(void*);
+        // Addresses are kept as plain bytes in the config
+        static IPAddress toIPAddress(const uint8_t*);
+        static void saveIPAddress(uint8_t*, const IPAddress&);
     public:
         EthernetUDP UDP;
-        IPAddress local_ip{192, 168, 1, 177};
-        IPAddress subnet_addr{255, 255, 255, 255};
-        IPAddress gateway_addr{255, 255, 255, 255};
+        // Defaults are in config_store.cpp
+        IPAddress local_ip;
+        IPAddress subnet_addr;
+        IPAddress gateway_addr;
         unsigned long packetsSent = 0, packetsRcvd = 0;
 
-        // Arduino intial setup function
+        // Arduino intial setup function, registers the link task
         void setup();
 
-        // Arduino loop call receives commands over UDP
+        // Polled by the UDP command task to receive commands
         //      When it gets a message it will return true and
         //      the packetBuffer can be processed
-        bool loop();
+        bool receive();
 
         void beginPacket();
+        // Drop or (re)start the connection depending on link status
+        void checkLink();
         bool connect();
         void endPacket();
         char* getPacketBuffer();
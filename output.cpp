@@ -3,21 +3,114 @@
 
 #define DEBUG 0
 
+#define RING_MASK (OUTPUT_TX_RING - 1)
+static_assert((OUTPUT_TX_RING & RING_MASK) == 0 && OUTPUT_TX_RING <= 128,
+        "TX ring indexes are free running bytes");
+
 extern network_control NET;
+extern task_scheduler TASKS;
+
+void Output::setup() {
+    tx_task = TASKS.add(F("tx"), txTask, this, 0);
+    TASKS.stop(tx_task);
+}
+
+void Output::txTask(void *ctx) {
+    Output *self = (Output*)ctx;
+    self->drain();
+    if (self->ring_head != self->ring_tail)
+        TASKS.wake(self->tx_task, TX_DRAIN_DELAY);
+}
+
+void Output::drain() {
+    int room = Serial.availableForWrite();
+    while (room-- > 0 && ring_tail != ring_head)
+        Serial.write(ring[ring_tail++ & RING_MASK]);
+}
+
+size_t Output::queue(uint8_t p) {
+    if ((uint8_t)(ring_head - ring_tail) == OUTPUT_TX_RING) {
+        #if OUTPUT_TX_BLOCK
+        // Make room the old way, by waiting on the UART
+        Serial.write(ring[ring_tail++ & RING_MASK]);
+        #else
+        tx_dropped++;
+        return 0;
+        #endif
+    }
+    if (ring_head == ring_tail)
+        TASKS.wake(tx_task);
+    ring[ring_head++ & RING_MASK] = p;
+    tx_queued++;
+    return 1;
+}
+
+size_t Output::send(const uint8_t *buffer, size_t size) {
+    if (udp_print) {
+        udp_bytes += size;
+        return NET.UDP.write(buffer, size);
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < size; i++)
+        n += queue(buffer[i]);
+    return n;
+}
 
 size_t Output::write(uint8_t p) {
+    if (!udp_print)
+        return queue(p);
+    stage[staged++] = p;
+    if (staged == OUTPUT_STAGE_SIZE)
+        flush();
+    return 1;
+}
+
+size_t Output::write(const uint8_t *buffer, size_t size) {
+    if (!udp_print)
+        return send(buffer, size);
+    // Blocks that fill the stage anyway skip the copy
+    if (staged + size > OUTPUT_STAGE_SIZE) {
+        flush();
+        if (size >= OUTPUT_STAGE_SIZE)
+            return send(buffer, size);
+    }
+    for (size_t i = 0; i < size; i++)
+        stage[staged++] = buffer[i];
+    if (staged == OUTPUT_STAGE_SIZE)
+        flush();
+    return size;
+}
+
+int Output::availableForWrite() {
     if (udp_print)
-        return NET.UDP.write(p);
-    else
-        return Serial.write(p);
+        return OUTPUT_STAGE_SIZE - staged;
+    return OUTPUT_TX_RING - (uint8_t)(ring_head - ring_tail);
+}
+
+void Output::flush() {
+    if (!udp_print)
+        drain();
+    else if (staged) {
+        send(stage, staged);
+        staged = 0;
+    }
 }
 
 void Output::udpBegin() {
     NET.beginPacket();
+    udp_bytes = 0;
     udp_print = true;
 }
 
 void Output::udpEnd() {
+    flush();
     NET.endPacket();
     udp_print = false;
-}
\ No newline at end of file
+}
+
+void Output::printStats(Print &Printer) {
+    Printer.print(F("Serial TX queued "));
+    Printer.print(tx_queued);
+    Printer.print(F(", dropped "));
+    Printer.println(tx_dropped);
+}
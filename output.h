@@ -1,23 +1,69 @@
 // output.h
 /* Wraps around Serial print functions and UDP send functions
-        to send output to correct location. */
+        to send output to correct location.
+    UDP bytes are staged and handed over in chunks, so a reply costs one
+        buffer update per chunk rather than per character.
+    Serial bytes go into a TX ring that the tx task moves into the UART's
+        own buffer as it frees up, so printing never waits on the baud rate.
+        Long replies should check availableForWrite() and pace themselves,
+        anything that doesn't fit the ring is dropped and counted. */
 #ifndef OUTPUT_H
 #define OUTPUT_H
 
 #include <Arduino.h>
 #include "network_control.h"
+#include "scheduler.h"
 #include "token_definitions.h"
 
+#define OUTPUT_STAGE_SIZE 32
+#define OUTPUT_TX_RING 128   // Power of two, at most 128
+#define OUTPUT_TX_BLOCK 0    // 1 waits on the UART when the ring is full instead
+#define TX_DRAIN_DELAY 10    // ms, the UART sends ~10 bytes in that at 9600 baud
+
 class Output : public Print
 {
+        private:
+                uint8_t stage[OUTPUT_STAGE_SIZE];
+                uint8_t staged = 0;
+                uint8_t ring[OUTPUT_TX_RING];
+                // Free running, only ever masked on access
+                uint8_t ring_head = 0, ring_tail = 0;
+                uint8_t tx_task = TASK_NONE;
+
+                // One-shot, woken while the ring holds anything
+                static void txTask(void*);
+
+                // Move as much of the ring into the UART as fits right now
+                void drain();
+
+                // Add a byte to the ring, returns 0 if it was dropped
+                size_t queue(uint8_t);
+
+                // Hand a block straight to the active sink
+                size_t send(const uint8_t*, size_t);
         public:
                 bool udp_print = false;
+                uint16_t udp_bytes = 0;     // In the current packet
+                uint32_t tx_queued = 0, tx_dropped = 0;
+
+                // Registers the tx task
+                void setup();
 
                 void udpBegin();
                 void udpEnd();
 
                 virtual size_t write(uint8_t);
+                virtual size_t write(const uint8_t*, size_t);
                 using Print::write;
+
+                // Bytes the active sink can take without dropping
+                virtual int availableForWrite();
+
+                // Push out whatever is waiting without blocking
+                virtual void flush();
+
+                // Prints the TX counters
+                void printStats(Print&);
 };
 
-#endif
\ No newline at end of file
+#endif
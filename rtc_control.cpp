@@ -4,58 +4,61 @@
 #define DEBUG 0
 
 extern Output out;
-extern network_control NET;
+
+void rtc_control::sync() {
+    epoch = toEpoch(Clock.read());
+    since_sync.restart();
+    transfers++;
+}
+
+void rtc_control::write(const DateTime &ts) {
+    Clock.write(ts);
+    epoch = toEpoch(ts);
+    since_sync.restart();
+    transfers++;
+}
+
+uint32_t rtc_control::now() {
+    if (since_sync.hasElapsed(RTC_RESYNC_MS))
+        sync();
+    return epoch + since_sync.elapsed() / 1000;
+}
 
 DateTime rtc_control::readTime() {
-    return Clock.read();
+    return fromEpoch(now());
 }
 
 void rtc_control::printStatus() {
+    DateTime ts = readTime();
     out.print(F("Date (yyyy/mm/dd): "));
-    if (out.udp_print) {
-        Clock.printDateTo_YMD(NET.UDP);
-        out.print(F("\n\rTime (hh:mm:ss): "));
-        Clock.printTimeTo_HMS(NET.UDP);
-    }
-    else {
-        Clock.printDateTo_YMD(Serial);
-        out.print(F("\n\rTime (hh:mm:ss): "));
-        Clock.printTimeTo_HMS(Serial);
-    }
+    Clock.printDateTo_YMD(out, ts);
+    out.print(F("\n\rTime (hh:mm:ss): "));
+    Clock.printTimeTo_HMS(out, ts);
+}
+
+void rtc_control::printStats(Print &Printer) {
+    Printer.print(F("RTC: I2C transfers "));
+    Printer.print(transfers);
+    Printer.print(F(", synced "));
+    Printer.print(since_sync.elapsed() / 1000);
+    Printer.println(F("s ago"));
 }
 
 void rtc_control::setup() {
     Clock.begin();
+    sync();
 }
 
 bool rtc_control::setDate(byte yy, byte mm, byte dd) {
-    DateTime ts = Clock.read();
+    DateTime ts = readTime();
     ts.Day    = (uint8_t)dd;
     ts.Month  = (uint8_t)mm;
     ts.Year   = (uint8_t)yy;
-    bool valid = true;
-    if (ts.Year > 99 || ts.Month > 12 ||
-            ts.Year < 1 || ts.Month < 1 || ts.Day < 1)
-        valid = false;
-    switch (ts.Month) {
-        case 12:
-        case 4:
-        case 6:
-        case 9:
-        case 11:
-            if (ts.Day > 30)
-                valid = false;
-            break;
-        case 2:
-            if (ts.Day > 29 || (ts.Year % 4 != 0 && ts.Day > 28))
-                valid = false;
-            break;
-        default:
-            if (ts.Day > 31)
-                valid = false;
-    }
+    bool valid = validDate(ts.Year, ts.Month, ts.Day);
     if (valid) {
-        Clock.write(ts);
+        // The day of the week follows from the date
+        ts = fromEpoch(toEpoch(ts));
+        write(ts);
         out.print(F("Date-Time set to "));
     }
     else
@@ -66,15 +69,13 @@ bool rtc_control::setDate(byte yy, byte mm, byte dd) {
 }
 
 bool rtc_control::setTime(byte hh, byte mm, byte ss) {
-    DateTime ts = Clock.read();
+    DateTime ts = readTime();
     ts.Second    = (uint8_t)ss;
     ts.Minute  = (uint8_t)mm;
     ts.Hour   = (uint8_t)hh;
-    bool valid = true;
-    if (ts.Second > 59 || ts.Minute > 59 || ts.Hour > 24)
-        valid = false;
+    bool valid = validTime(ts.Hour, ts.Minute, ts.Second);
     if (valid) {
-        Clock.write(ts);
+        write(ts);
         out.print(F("Time set to "));
     }
     else
@@ -85,14 +86,8 @@ bool rtc_control::setTime(byte hh, byte mm, byte ss) {
 }
 
 void rtc_control::print(const DateTime &ts) {
-    if (out.udp_print) {
-        Clock.printDateTo_YMD(NET.UDP, ts);
-        out.print(F(" "));
-        Clock.printTimeTo_HMS(NET.UDP, ts);
-    }
-    else {
-        Clock.printDateTo_YMD(Serial, ts);
-        out.print(F(" "));
-        Clock.printTimeTo_HMS(Serial, ts);
-    }
+    // Through out, so it stays in order with its staged output
+    Clock.printDateTo_YMD(out, ts);
+    out.print(F(" "));
+    Clock.printTimeTo_HMS(out, ts);
 }
\ No newline at end of file
@@ -1,5 +1,10 @@
 // rtc_control.h
-/* Class to wrap around the RTC time controller */
+/* Class to wrap around the RTC time controller
+    The time is kept in RAM as seconds since 2000 and moved on by millis(),
+        so reading it is a copy rather than an I2C transfer. It is read
+        back from the DS3231 every RTC_RESYNC_MS, before millis() (a
+        ceramic resonator on the Uno) can drift far from it. The SQW pin
+        can't tick it instead, INT0 and INT1 are taken by the LCD. */
 #ifndef RTC_H
 #define RTC_H
 
@@ -7,18 +12,35 @@
 #include <DS3231_Simple.h>
 #include "token_definitions.h"
 #include "output.h"
+#include "calendar.h"
+#include "timer.h"
+
+#define RTC_RESYNC_MS 60000
 
 class rtc_control
 {
     private:
         DS3231_Simple Clock;
+        uint32_t epoch = 0;         // Seconds since 2000 at the last sync
+        elapsed_timer since_sync;
+        uint32_t transfers = 0;     // I2C reads and writes of the clock
+
+        // Read the DS3231 into the RAM copy
+        void sync();
+        // Write the DS3231 and take the time as the RAM copy
+        void write(const DateTime&);
     public:
-        // Wraps the Clock's read function
+        // Current time from the RAM copy, resyncing it first if it's due
         DateTime readTime();
-        
+        // The same in seconds since 2000, see calendar.h
+        uint32_t now();
+
         // Just prints current time
         void printStatus();
 
+        // I2C transfers so far and how long ago the last sync was
+        void printStats(Print&);
+
         // Just outputs current time/date
         void setup();
 
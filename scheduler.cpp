@@ -0,0 +1,104 @@
+// scheduler.cpp
+#include "scheduler.h"
+#include <avr/sleep.h>
+
+#define DEBUG 0
+
+uint8_t task_scheduler::add(const __FlashStringHelper *name, task_fn fn, void *ctx,
+        uint32_t period, uint32_t delay, uint16_t budget) {
+    if (task_count >= MAX_TASKS) {
+        refused++;
+        return TASK_NONE;
+    }
+    task &t = tasks[task_count];
+    t.fn = fn;
+    t.ctx = ctx;
+    t.name = name;
+    t.due.set(delay);
+    t.period = period;
+    t.budget = budget;
+    t.active = true;
+    t.runs = 0;
+    t.overruns = t.max_run = t.max_late = 0;
+    return task_count++;
+}
+
+void task_scheduler::loop() {
+    bool ran = false;
+    for (uint8_t i = 0; i < task_count; i++) {
+        task &t = tasks[i];
+        if (!t.active)
+            continue;
+        int32_t late = t.due.late();
+        if (late < 0)
+            continue;
+
+        // Pick the next deadline before running so the task can override it
+        if (t.period == 0)
+            t.active = false;
+        else if ((uint32_t)late >= t.period)
+            t.due.set(t.period); // Missed whole periods, don't burst
+        else
+            t.due.advance(t.period);
+
+        uint32_t start = micros();
+        t.fn(t.ctx);
+        uint32_t run = micros() - start;
+
+        t.runs++;
+        if (run > t.budget)
+            t.overruns++;
+        t.max_run = max(t.max_run, (uint16_t)min(run, 65535UL));
+        t.max_late = max(t.max_late, (uint16_t)min((uint32_t)late, 65535UL));
+        ran = true;
+        #if DEBUG >= 2
+        if (run > t.budget) {
+            Serial.print(F("Task overrun: "));
+            Serial.print(t.name);
+            Serial.print(F(" "));
+            Serial.println(run);
+        }
+        #endif
+    }
+    if (ran)
+        return;
+    // Nothing due, sleep until the next interrupt (timer0 ticks every ~1ms,
+    //  serial RX also wakes us)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+}
+
+bool task_scheduler::printStatsLine(Print &Printer, uint8_t n) {
+    if (n == 0) {
+        Printer.println(F("Task\tPeriod\tRuns\tOver\tMax us\tMax late"));
+        return true;
+    }
+    if (n > task_count)
+        return false;
+    task &t = tasks[n - 1];
+    Printer.print(t.name);
+    Printer.print(F("\t"));
+    Printer.print(t.period);
+    Printer.print(F("\t"));
+    Printer.print(t.runs);
+    Printer.print(F("\t"));
+    Printer.print(t.overruns);
+    Printer.print(F("\t"));
+    Printer.print(t.max_run);
+    Printer.print(F("\t"));
+    Printer.println(t.max_late);
+    return true;
+}
+
+void task_scheduler::stop(uint8_t id) {
+    if (id >= task_count)
+        return;
+    tasks[id].active = false;
+}
+
+void task_scheduler::wake(uint8_t id, uint32_t delay) {
+    if (id >= task_count)
+        return;
+    tasks[id].due.set(delay);
+    tasks[id].active = true;
+}
@@ -0,0 +1,61 @@
+// scheduler.h
+/* Cooperative deadline scheduler. Modules register periodic or one-shot
+        tasks and loop() only runs what is due, sleeping in between. */
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <Arduino.h>
+#include "timer.h"
+
+#define MAX_TASKS 14 // 12 registered by the sketch, two spare
+#define TASK_NONE 255
+
+typedef void (*task_fn)(void*);
+
+struct task {
+    task_fn fn;
+    void *ctx;
+    const __FlashStringHelper *name;
+    deadline due;
+    uint32_t period;    // 0 for one-shot
+    uint16_t budget;    // Allowed run time in micros
+    bool active;
+    // Accounting
+    uint32_t runs;
+    uint16_t overruns;  // Runs that went over budget
+    uint16_t max_run;   // Longest run in micros
+    uint16_t max_late;  // Longest start delay past deadline in millis
+};
+
+class task_scheduler
+{
+    private:
+        task tasks[MAX_TASKS];
+        uint8_t task_count = 0;
+        uint8_t refused = 0;    // add() calls that found the table full
+    public:
+        // Register a task, returns its id or TASK_NONE if the table is full
+        //  A period of 0 makes a one-shot task that can be re-armed with wake()
+        uint8_t add(const __FlashStringHelper*, task_fn, void*,
+                uint32_t period, uint32_t delay = 0, uint16_t budget = 1000);
+
+        // Run every task that is due, or idle until the next tick if none are
+        void loop();
+
+        // Number of registered tasks
+        uint8_t count() { return task_count; }
+        // Tasks that didn't fit, anything but 0 means raise MAX_TASKS
+        uint8_t refusedCount() { return refused; }
+
+        // Print line n of the accounting, the header then one per task
+        //  Returns false once past the last task
+        bool printStatsLine(Print&, uint8_t);
+
+        // Deactivate a task until it is woken
+        void stop(uint8_t);
+
+        // (Re)arm a task to run after the given delay
+        void wake(uint8_t, uint32_t delay = 0);
+};
+
+#endif
@@ -0,0 +1,994 @@
+// bench.cpp
+/* Host micro-benchmarks of sketch hot paths, run with sim -b <name>.
+        These time the host CPU, so only compare numbers from the same machine. */
+#include <chrono>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "sim_hal.h"
+#include <Arduino.h>
+#include "calendar.h"
+#include "config_store.h"
+#include "dht_control.h"
+#include "lcd_buffer.h"
+#include "lcd_ui.h"
+#include "led_control.h"
+#include "output.h"
+#include "tokenizer.h"
+
+extern config_store CONFIG;
+extern dht_control DHT;
+extern eeprom_cache EECACHE;
+extern lcd_ui LCD_UI;
+extern led_control LED;
+extern network_control NET;
+extern Output out;
+
+void setup();
+void loop();
+extern bool (*pager)(uint16_t);
+void parseInput(char*, uint8_t);
+void parseTokens();
+extern uint8_t token_buffer[];
+extern uint8_t token_length;
+
+// As in dht_control.cpp
+#define EEPROM_LOGS 0
+#define EEPROM_LOG_STATS 281
+// As in Main.cpp
+#define EEPROM_CONFIG 300
+// One EEPROM byte, as hal.cpp models it
+#define EEPROM_BYTE_US 3300
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double secondsSince(bench_clock::time_point start) {
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// Scripted command burst like the collectors replay over UDP
+static const char *const parse_script[] = {
+    "dht log info",
+    "led blink",
+    "rgb 10 200 30",
+    "set blink 750",
+    "set time 12 30 45",
+    "set dht scale 1",
+    "dht",
+    "time",
+    "led yellow",
+    "version",
+};
+
+static int benchParse() {
+    const uint8_t n = sizeof(parse_script) / sizeof(parse_script[0]);
+    char buffers[n][24];
+    uint8_t lengths[n];
+    unsigned long tokens = 0;
+    const unsigned long rounds = 200000;
+
+    bench_clock::time_point start = bench_clock::now();
+    for (unsigned long r = 0; r < rounds; r++) {
+        for (uint8_t i = 0; i < n; i++) {
+            // parseInput may write into its input, refresh it every pass
+            lengths[i] = strlen(parse_script[i]);
+            memcpy(buffers[i], parse_script[i], lengths[i] + 1);
+            parseInput(buffers[i], lengths[i]);
+            tokens += token_length;
+        }
+    }
+    double secs = secondsSince(start);
+    printf("parse: %lu commands, %lu tokens in %.3f s\n", rounds * n, tokens, secs);
+    printf("  %.0f commands/s  %.0f tokens/s\n", rounds * n / secs, tokens / secs);
+    return 0;
+}
+
+// Commands whose handlers print little, so dispatch itself dominates
+static const char *const dispatch_script[] = {
+    "led blink",
+    "led on",
+    "rgb 10 200 30",
+    "set blink 750",
+    "set dht scale 1",
+    "led yellow",
+    "rgb 1 2",
+    "dht log clear now",
+    "set time 12 30 45",    // The longest, fills the token buffer
+};
+
+static int benchDispatch() {
+    const uint8_t n = sizeof(dispatch_script) / sizeof(dispatch_script[0]);
+    uint8_t tokens[n][l_TOKEN_BUFFER + 1];
+    uint8_t lengths[n];
+    for (uint8_t i = 0; i < n; i++) {
+        char buffer[24];
+        strcpy(buffer, dispatch_script[i]);
+        parseInput(buffer, strlen(buffer));
+        lengths[i] = token_length;
+        memcpy(tokens[i], token_buffer, l_TOKEN_BUFFER);
+    }
+    const unsigned long rounds = 200000;
+    bench_clock::time_point start = bench_clock::now();
+    for (unsigned long r = 0; r < rounds; r++) {
+        for (uint8_t i = 0; i < n; i++) {
+            memcpy(token_buffer, tokens[i], l_TOKEN_BUFFER);
+            token_length = lengths[i];
+            parseTokens();
+        }
+    }
+    double secs = secondsSince(start);
+    printf("dispatch: %lu commands in %.3f s, %.1f ns/command\n", rounds * n, secs,
+            secs * 1e9 / (rounds * n));
+    return 0;
+}
+
+// Runs a command the way the CLI task would, then for Serial keeps the
+//  scheduler going until the pager and TX ring are done with it
+static void runCommand(const char *command) {
+    char buffer[24];
+    strcpy(buffer, command);
+    parseInput(buffer, strlen(buffer));
+    parseTokens();
+    if (!out.udp_print) {
+        while (pager != NULL || out.availableForWrite() < OUTPUT_TX_RING)
+            loop();
+    }
+}
+
+static void outputHelp() {
+    runCommand("help");
+}
+
+static void outputLogs() {
+    runCommand("dht log");
+}
+
+// Runs one output workload to a sink, reporting host throughput and the
+//  modeled AVR time and device operations for a single pass
+static void benchSink(const char *name, void (*fn)(), bool udp) {
+    const unsigned long rounds = 2000;
+    uint8_t sink = udp ? SIM_NET : SIM_SERIAL;
+    Serial.flush();
+    uint64_t clock = sim_clock();
+    uint32_t calls = sim_devices[sink].calls;
+    uint32_t bytes = sim_devices[sink].bytes;
+    if (udp) out.udpBegin();
+    fn();
+    if (udp) out.udpEnd();
+    Serial.flush();
+    uint64_t us = sim_clock() - clock;
+    calls = sim_devices[sink].calls - calls;
+    bytes = sim_devices[sink].bytes - bytes;
+
+    bench_clock::time_point start = bench_clock::now();
+    for (unsigned long r = 0; r < rounds; r++) {
+        if (udp) out.udpBegin();
+        fn();
+        if (udp) out.udpEnd();
+    }
+    double secs = secondsSince(start);
+    printf("%-6s %-6s %6u bytes %6u calls %9.1f B/ms modeled %9.0f B/ms host\n",
+            name, udp ? "udp" : "serial", bytes, calls,
+            us ? bytes * 1000.0 / us : 0.0, bytes * rounds / (secs * 1000));
+}
+
+static int benchOutput() {
+    setup();
+    DHT.clearLog();
+    for (uint8_t i = 0; i < 27; i++)
+        DHT.logReading();
+    benchSink("help", outputHelp, false);
+    benchSink("help", outputHelp, true);
+    benchSink("logs", outputLogs, false);
+    benchSink("logs", outputLogs, true);
+    return 0;
+}
+
+// A year of logging every 15 minutes, straight into the log code so it
+//  takes seconds rather than a year of simulated loops
+static int benchWear() {
+    const uint32_t logs = 365UL * 24 * 4;
+    const uint16_t log_bytes = 247;
+    setup();
+    DHT.clearLog();
+    for (uint16_t i = 0; i < log_bytes; i++)
+        sim_eeprom_wear[i] = 0;
+    for (uint32_t i = 0; i < logs; i++) {
+        sim_advance(15UL * 60 * 1000000);
+        DHT.temperature = 180 + i % 120;
+        DHT.humidity = 400 + (i % 50) * 2;
+        DHT.logReading();
+    }
+    uint32_t worst = 0, total = 0;
+    uint16_t worst_at = 0;
+    for (uint16_t i = 0; i < log_bytes; i++) {
+        total += sim_eeprom_wear[i];
+        if (sim_eeprom_wear[i] > worst) {
+            worst = sim_eeprom_wear[i];
+            worst_at = i;
+        }
+    }
+    printf("wear: %lu logs, %lu cell writes over bytes 0-%u\n",
+            (unsigned long)logs, (unsigned long)total, log_bytes - 1);
+    printf("  mean %.0f writes/cell, worst %lu at byte %u\n",
+            (double)total / log_bytes, (unsigned long)worst, worst_at);
+    printf("  worst cell reaches 100k cycles in %.1f years\n", 100000.0 / worst);
+    for (uint16_t row = 0; row < log_bytes; row += 16) {
+        printf("  %3u:", row);
+        for (uint16_t i = row; i < row + 16 && i < log_bytes; i++)
+            printf(" %5lu", (unsigned long)sim_eeprom_wear[i]);
+        printf("\n");
+    }
+    return 0;
+}
+
+// Log capacity for a few kinds of readings, each run until the ring has
+//  wrapped several times so it reports the steady state
+struct fit_trace {
+    const char *name;
+    uint32_t interval_ms;
+    float (*temp)(uint32_t);
+    float (*humid)(uint32_t);
+};
+
+// A reading as the sensor gives it
+static int16_t tenths(float v) { return lround(v * 10); }
+
+static float dailyTemp(uint32_t i) { return 21 + 2.5 * sin(i * 2 * M_PI / 96); }
+static float dailyHumid(uint32_t i) { return 45 + 6 * sin(i * 2 * M_PI / 96 + 1); }
+static float noisyTemp(uint32_t i) { return 21 + (rand() % 5) - 2; }
+static float noisyHumid(uint32_t i) { return 45 + (rand() % 9) - 4; }
+static float stepTemp(uint32_t i) { return (i / 8) % 2 ? 30 : 18; }
+
+static int benchFit() {
+    const fit_trace traces[] = {
+        {"daily cycle", 900000, dailyTemp, dailyHumid},
+        {"daily, clock drift", 900900, dailyTemp, dailyHumid},
+        {"noisy +-2C +-4%", 900000, noisyTemp, noisyHumid},
+        {"12C swings", 900000, stepTemp, dailyHumid},
+    };
+    setup();
+    srand(1);
+    printf("log capacity in the 247 byte region at 15 minute logging\n");
+    for (const fit_trace &t : traces) {
+        DHT.clearLog();
+        for (uint32_t i = 0; i < 2000; i++) {
+            sim_advance(t.interval_ms * 1000);
+            DHT.temperature = tenths(t.temp(i));
+            DHT.humidity = tenths(t.humid(i));
+            DHT.logReading();
+        }
+        uint16_t n = DHT.getEntriesCount();
+        DateTime first = DHT.getLogEntry(0).ts, last = DHT.getLogEntry(n - 1).ts;
+        double span = secondsBetween(first, last) / 3600.0;
+        printf("  %-20s %4u entries, %5.1f hours\n", t.name, n, span);
+    }
+    return 0;
+}
+
+// Let the EEPROM ready interrupt write out everything queued
+static void drainEeprom() {
+    EECACHE.flush();
+    while (EECACHE.queued())
+        sim_advance(1000);
+}
+
+static bool sameStats(const log_stats &a, const log_stats &b) {
+    return a.count == b.count && a.temp_sum == b.temp_sum &&
+        a.humid_sum == b.humid_sum && a.temp_min == b.temp_min &&
+        a.temp_max == b.temp_max && a.humid_min == b.humid_min &&
+        a.humid_max == b.humid_max;
+}
+
+// Cost of "dht log info" and whether the statistics survive resets, run
+//  after every append so each point in a block is a reset point
+static int benchStats() {
+    setup();
+    DHT.clearLog();
+    srand(2);
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < 600; i++) {
+        sim_advance(900000000UL);
+        DHT.temperature = tenths(i < 300 ? dailyTemp(i) : -5 + rand() % 40);
+        DHT.humidity = tenths(dailyHumid(i));
+        DHT.logReading();
+        // What a reset would find
+        dht_log rebooted;
+        rebooted.begin(EEPROM_LOGS, EEPROM_LOG_STATS, 900);
+        if (!sameStats(rebooted.stats(), DHT.getLogStats()))
+            mismatches++;
+    }
+    const log_stats &stats = DHT.getLogStats();
+    printf("stats: %lu logs, %u still stored, %lu mismatches after reset\n",
+            (unsigned long)stats.count, DHT.getEntriesCount(),
+            (unsigned long)mismatches);
+    printf("  min %d max %d mean %.2f C, humidity %u-%u mean %.2f%%\n",
+            stats.temp_min, stats.temp_max, (double)stats.temp_sum / stats.count,
+            stats.humid_min, stats.humid_max, (double)stats.humid_sum / stats.count);
+
+    drainEeprom();
+    uint32_t reads = sim_eeprom_reads;
+    runCommand("dht log info");
+    printf("  dht log info: %lu EEPROM reads\n",
+            (unsigned long)(sim_eeprom_reads - reads));
+
+    // A torn summary falls back to the entries still in the log
+    drainEeprom();
+    uint16_t check = EEPROM_LOG_STATS + LOG_SUMMARY_SIZE - 1;
+    EEPROM.write(check, ~EEPROM.read(check));
+    reads = sim_eeprom_reads;
+    dht_log rebooted;
+    rebooted.begin(EEPROM_LOGS, EEPROM_LOG_STATS, 900);
+    printf("  torn summary: rebuilt %lu entries with %lu EEPROM reads\n",
+            (unsigned long)rebooted.stats().count,
+            (unsigned long)(sim_eeprom_reads - reads));
+    return mismatches != 0 ||
+            rebooted.stats().count != DHT.getEntriesCount();
+}
+
+static void cacheRun(const char *name, void (*fn)()) {
+    uint32_t issued = EECACHE.writesIssued(), saved = EECACHE.writesSaved();
+    uint32_t flushed = EECACHE.bytesFlushed();
+    uint64_t busy = sim_devices[SIM_EEPROM].us;
+    fn();
+    uint64_t blocked = sim_devices[SIM_EEPROM].us - busy;
+    drainEeprom();
+    printf("  %-28s %6lu %6lu %8lu %9.1f\n", name,
+            (unsigned long)(EECACHE.writesIssued() - issued),
+            (unsigned long)(EECACHE.writesSaved() - saved),
+            (unsigned long)(EECACHE.bytesFlushed() - flushed),
+            blocked / 1000.0);
+}
+
+static void clearTwice() {
+    DHT.clearLog();
+    DHT.clearLog();
+}
+
+// Someone stepping the alarm gates up and down from the LCD, saving as they go
+static void nudgeGates() {
+    for (int i = 0; i < 10; i++)
+        DHT.setAlarmGates(10 + (i + 1) % 3, 20, 27, 32 - (i + 1) % 2);
+}
+
+static void resaveAddresses() {
+    for (int i = 0; i < 5; i++) {
+        NET.saveDestAddrPort(IPAddress(192, 168, 1, 20 + i), 8888);
+        NET.saveLocalIPAddr(IPAddress(192, 168, 1, 177));
+    }
+}
+
+static void logDay() {
+    for (int i = 0; i < 96; i++) {
+        sim_advance(900000000UL);
+        DHT.temperature = tenths(dailyTemp(i));
+        DHT.humidity = tenths(dailyHumid(i));
+        DHT.logReading();
+    }
+}
+
+// Write-back cache counters for each kind of persistence, every run ends
+//  with a flush so nothing is left pending
+static int benchCache() {
+    setup();
+    DHT.setAlarmGates(10, 20, 27, 32);
+    NET.saveLocalIPAddr(IPAddress(192, 168, 1, 177));
+    drainEeprom();
+    printf("eeprom cache                  issued  saved  flushed  blocked ms\n");
+    cacheRun("10 alarm gate saves", nudgeGates);
+    cacheRun("5 address saves", resaveAddresses);
+    cacheRun("a day of logs", logDay);
+    cacheRun("clear log twice", clearTwice);
+    printf("  queue peak %u of %u, %u deferred, %u stalls\n",
+            EECACHE.queue_peak, EEC_QUEUE, EECACHE.deferred, EECACHE.stalls);
+    uint16_t stalls = EECACHE.stalls;
+
+    // A read that misses the cache and the queue while a full queue is
+    //  being written should only wait out the byte in flight
+    for (uint8_t i = 0; i < EEC_QUEUE; i++)
+        EECACHE.write(400 + i, EECACHE.read(400 + i) ^ 0x55);
+    EECACHE.flush();
+    sim_advance(1000);
+    uint64_t start = sim_clock();
+    uint8_t value = EECACHE.read(600);
+    uint32_t waited = sim_clock() - start;
+    bool right = value == EEPROM.read(600);
+    drainEeprom();
+    printf("  read behind a full queue: %.1f ms, %s\n", waited / 1000.0,
+            right ? "right byte" : "WRONG byte");
+    return stalls || waited > EEPROM_BYTE_US || !right;
+}
+
+static void printConfig(const char *name, config_store &config, uint32_t reads) {
+    const config_data &d = config.data;
+    static const char *const sources[] = {"loaded", "migrated", "defaults",
+            "upgraded"};
+    printf("  %-20s %-8s %2lu reads  dest %u.%u.%u.%u:%u  ip %u.%u.%u.%u  "
+            "gates %d %d %d %d  log format %u  buttons %u %u %u %u %u\n",
+            name, sources[config.source], (unsigned long)reads,
+            d.dest_ip[0], d.dest_ip[1], d.dest_ip[2], d.dest_ip[3], d.dest_port,
+            d.local_ip[0], d.local_ip[1], d.local_ip[2], d.local_ip[3],
+            d.alarm_gates[0], d.alarm_gates[1], d.alarm_gates[2],
+            d.alarm_gates[3], d.log_format, d.button_levels[0],
+            d.button_levels[1], d.button_levels[2], d.button_levels[3],
+            d.button_levels[4]);
+}
+
+// Boots a config store and prints it, false unless it came from the
+//  expected source with the expected settings
+static bool bootConfig(const char *name, byte source,
+        const config_data &expected) {
+    config_store config;
+    uint32_t reads = sim_eeprom_reads;
+    config.load(EEPROM_CONFIG);
+    printConfig(name, config, sim_eeprom_reads - reads);
+    drainEeprom();
+    bool right = config.source == source &&
+            !memcmp(&config.data, &expected, offsetof(config_data, crc));
+    if (!right)
+        printf("  %s: not the expected settings\n", name);
+    return right;
+}
+
+// CRC-16/CCITT, as config_store works it out
+static uint16_t ccitt(const uint8_t *p, uint8_t length) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)p[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Boots against a blank chip, one in the old layout as an AVR wrote it,
+//  the config that left behind, that config with a byte flipped and a
+//  version 1 block
+static int benchConfig() {
+    printf("config boots\n");
+    // Without a config the log's format is unknown, so it reads as 0
+    config_data defaults;
+    memcpy_P(&defaults, &config_defaults, sizeof(defaults));
+    defaults.log_format = 0;
+    for (uint16_t i = 0; i < EEPROM.length(); i++)
+        EEPROM.write(i, 0xFF);
+    bool right = bootConfig("blank", config_store::DEFAULTS, defaults);
+
+    const uint8_t legacy[] = {
+        0, 0, 10, 0, 0, 42,         // dest_ip, vtable pointer first
+        0xB8, 0x22,                 // dest_port 8888
+        0, 0, 10, 0, 0, 50,         // local_ip
+        0, 0, 255, 255, 0, 0,       // subnet
+        0, 0, 10, 0, 0, 1,          // gateway
+        50, 0, 65, 0, 78, 0, 85, 0  // alarm gates
+    };
+    for (uint16_t i = 0; i < EEPROM.length(); i++)
+        EEPROM.write(i, 0xFF);
+    for (uint8_t i = 0; i < sizeof(legacy); i++)
+        EEPROM.write(247 + i, legacy[i]);
+    config_data migrated = defaults;
+    const uint8_t dest[] = {10, 0, 0, 42}, local[] = {10, 0, 0, 50},
+            subnet[] = {255, 255, 0, 0}, gateway[] = {10, 0, 0, 1};
+    const int16_t gates[] = {50, 65, 78, 85};
+    memcpy(migrated.dest_ip, dest, 4);
+    migrated.dest_port = 8888;
+    memcpy(migrated.local_ip, local, 4);
+    memcpy(migrated.subnet, subnet, 4);
+    memcpy(migrated.gateway, gateway, 4);
+    memcpy(migrated.alarm_gates, gates, sizeof(gates));
+    right &= bootConfig("old layout", config_store::MIGRATED, migrated);
+    right &= bootConfig("after migration", config_store::LOADED, migrated);
+    // The old layout is erased so it can't come back
+    for (uint8_t i = 0; i < sizeof(legacy); i++)
+        if (EEPROM.read(247 + i) != 0xFF) {
+            printf("  old layout not erased at %u\n", 247 + i);
+            right = false;
+            break;
+        }
+    EEPROM.write(EEPROM_CONFIG + 4, EEPROM.read(EEPROM_CONFIG + 4) ^ 1);
+    right &= bootConfig("corrupted", config_store::DEFAULTS, defaults);
+
+    // Version 1 had a reserved byte where the button levels start and its
+    //  CRC at 30
+    uint8_t v1[32];
+    for (uint8_t i = 0; i < 30; i++)
+        v1[i] = EEPROM.read(EEPROM_CONFIG + i);
+    v1[1] = 1;
+    v1[11] = 7;     // local_ip 192.168.1.7
+    v1[29] = 0;
+    uint16_t crc = ccitt(v1, 30);
+    v1[30] = crc & 0xFF;
+    v1[31] = crc >> 8;
+    for (uint8_t i = 0; i < sizeof(v1); i++)
+        EEPROM.write(EEPROM_CONFIG + i, v1[i]);
+    config_data upgraded = defaults;
+    upgraded.local_ip[3] = 7;
+    right &= bootConfig("version 1", config_store::UPGRADED, upgraded);
+    right &= bootConfig("after upgrade", config_store::LOADED, upgraded);
+    return !right;
+}
+
+// Runs loop() until the clock passes end, returns the longest pass not
+//  counting time asleep. The most one pass spent on the LCD goes in
+//  worst_lcd.
+static uint32_t worst_lcd = 0;
+
+static uint32_t loopUntil(uint64_t end) {
+    uint32_t worst = 0;
+    while (sim_clock() < end) {
+        uint64_t start = sim_clock(), idle = sim_devices[SIM_IDLE].us;
+        uint64_t lcd = sim_devices[SIM_LCD].us;
+        loop();
+        uint32_t busy = (sim_clock() - start) - (sim_devices[SIM_IDLE].us - idle);
+        worst = max(worst, busy);
+        worst_lcd = max(worst_lcd, (uint32_t)(sim_devices[SIM_LCD].us - lcd));
+    }
+    return worst;
+}
+
+// Ten minutes on the home screen, which redraws every 5s, then paging
+//  through the top level screens with the right button
+// Text drawn at a random place, into the buffer and into what the screen
+//  should end up showing
+static void drawRandom(lcd_buffer &lcd, char expected[LCD_ROWS][LCD_COLS]) {
+    uint8_t row = rand() % LCD_ROWS, col = rand() % LCD_COLS;
+    char text[9];
+    uint8_t length = 1 + rand() % 8;
+    for (uint8_t i = 0; i < length; i++)
+        text[i] = 'a' + rand() % 26;
+    text[length] = 0;
+    lcd.setCursor(col, row);
+    lcd.print(text);
+    for (uint8_t i = 0; i < length && col + i < LCD_COLS; i++)
+        expected[row][col + i] = text[i];
+}
+
+// Random frames through a buffer of the bench's own, sent in short slices
+//  and drawn over part way through, against what the LCD ends up showing.
+//  The sketch's buffer is stale after this.
+static int checkLcdBuffer() {
+    LiquidCrystal display(0, 0, 0, 0, 0, 0);
+    display.begin(LCD_COLS, LCD_ROWS);
+    lcd_buffer lcd;
+    char expected[LCD_ROWS][LCD_COLS];
+    memset(expected, ' ', sizeof(expected));
+    srand(3);
+    const uint16_t frames = 500;
+    uint16_t wrong = 0;
+    uint32_t slices = 0;
+    for (uint16_t f = 0; f < frames; f++) {
+        for (uint8_t n = 1 + rand() % 6; n > 0; n--)
+            drawRandom(lcd, expected);
+        for (slices++; !lcd.send(display, 150); slices++)
+            if (rand() % 3 == 0)
+                drawRandom(lcd, expected);
+        for (uint8_t r = 0; r < LCD_ROWS; r++)
+            if (memcmp(sim_lcd_row(r), expected[r], LCD_COLS))
+                wrong++;
+    }
+    printf("  %u random frames in %lu slices, %u rows wrong on the LCD\n",
+            frames, (unsigned long)slices, wrong);
+    return wrong != 0;
+}
+
+static int benchLcd() {
+    setup();
+    // Past the boot time config and log writes
+    loopUntil(sim_clock() + 10000000ULL);
+    uint64_t end = sim_clock() + 600000000ULL;
+    uint32_t bytes = sim_devices[SIM_LCD].bytes;
+    uint64_t busy = sim_devices[SIM_LCD].us;
+    uint32_t worst = loopUntil(end);
+    uint32_t redraws = 120;
+    printf("lcd: %u redraws of the home screen\n", redraws);
+    printf("  %.1f HD44780 bytes and %.0f us per redraw, worst loop %u us\n",
+            (double)(sim_devices[SIM_LCD].bytes - bytes) / redraws,
+            (double)(sim_devices[SIM_LCD].us - busy) / redraws, worst);
+    printf("  |%s|\n", sim_lcd_row(0));
+    printf("  |%s|\n", sim_lcd_row(1));
+
+    const uint8_t presses = 8;
+    bytes = sim_devices[SIM_LCD].bytes;
+    worst = worst_lcd = 0;
+    for (uint8_t i = 0; i < presses; i++) {
+        // max() is a macro, it would run the loop twice
+        sim_set_adc(A0, 500);  // Right
+        uint32_t down = loopUntil(sim_clock() + 300000);
+        sim_set_adc(A0, 1023);
+        uint32_t up = loopUntil(sim_clock() + 300000);
+        worst = max(worst, max(down, up));
+    }
+    printf("  %u screen changes: %.1f bytes each, worst loop %u us, "
+            "%u us of it LCD\n", presses,
+            (double)(sim_devices[SIM_LCD].bytes - bytes) / presses, worst,
+            worst_lcd);
+    printf("  |%s|\n", sim_lcd_row(0));
+    printf("  |%s|\n", sim_lcd_row(1));
+    return checkLcdBuffer();
+}
+
+// Walks every screen of the menu with the buttons, printing each one
+static int benchMenu() {
+    setup();
+    loopUntil(sim_clock() + 3600000000ULL); // An hour of logs to browse
+    // Left, Right, Up, Down, X (OK) and the ADC reading each one gives
+    static const char keys[] = "LRUDX";
+    static const int volts[] = {10, 500, 150, 330, 740};
+    const char *walk = "RRRXRXUXXRRRRRRRRRLXXURXLLRUXRRRRRRU";
+    printf("menu: %s\n", walk);
+    for (const char *k = walk; *k; k++) {
+        sim_set_adc(A0, volts[strchr(keys, *k) - keys]);
+        loopUntil(sim_clock() + 200000);
+        sim_set_adc(A0, 1023);
+        loopUntil(sim_clock() + 200000);
+        printf("  %c |%s|", *k, sim_lcd_row(0));
+        printf(" |%s|\n", sim_lcd_row(1));
+    }
+    return 0;
+}
+
+// A minute with every light blinking and the user light's color changed
+//  each second, as an alarm would
+static int benchLed() {
+    // millis() wraps 200s in, during the last run
+    sim_set_wrap_offset(200000);
+    setup();
+    loopUntil(sim_clock() + 10000000ULL);
+    for (uint8_t i = 0; i < NUM_LEDS; i++)
+        LED.setLightStatus(i, t_BLINK);
+    uint32_t calls = sim_devices[SIM_LED].calls;
+    uint64_t busy = sim_devices[SIM_LED].us;
+    for (uint8_t s = 0; s < 60; s++) {
+        LED.setRGBColor(0, s * 4, 0, 50);
+        LED.setLightStatus(0, t_BLINK);
+        loopUntil(sim_clock() + 1000000);
+    }
+    printf("led: 60s, %u lights blinking, a color change a second\n",
+            NUM_LEDS);
+    printf("  %u strip sends, %.1f ms with interrupts off\n",
+            sim_devices[SIM_LED].calls - calls,
+            (sim_devices[SIM_LED].us - busy) / 1000.0);
+
+    // Each light on its own effect, then all of them steady
+    LED.setEffect(0, t_BLINK, 500, 0);
+    LED.setEffect(1, t_BLINK, 500, 250);
+    LED.setCycle(2, LED_PALETTE_HOT, 1200);
+    LED.setEffect(3, LED_BREATHE, 3000, 0);
+    calls = sim_devices[SIM_LED].calls;
+    loopUntil(sim_clock() + 60000000ULL);
+    printf("  60s of blink, blink half a period behind, alarm cycle and "
+            "breathe: %u strip sends\n", sim_devices[SIM_LED].calls - calls);
+    for (uint8_t i = 0; i < NUM_LEDS; i++)
+        LED.setLightStatus(i, t_ON);
+    calls = sim_devices[SIM_LED].calls;
+    loopUntil(sim_clock() + 60000000ULL);
+    printf("  60s all steady: %u strip sends\n",
+            sim_devices[SIM_LED].calls - calls);
+
+    // A period that isn't a whole fraction of the wrap, every half of it
+    //  should still take 350ms
+    LED.setEffect(0, t_BLINK, 700, 0);
+    CRGB last = FastLED.getLeds()[0];
+    uint64_t changed = 0;
+    uint32_t shortest = 0xFFFFFFFF, longest = 0;
+    for (uint64_t end = sim_clock() + 20000000ULL; sim_clock() < end; ) {
+        loopUntil(sim_clock() + 1000);
+        if (FastLED.getLeds()[0] == last)
+            continue;
+        last = FastLED.getLeds()[0];
+        if (changed) {
+            uint32_t gap = (sim_clock() - changed) / 1000;
+            shortest = min(shortest, gap);
+            longest = max(longest, gap);
+        }
+        changed = sim_clock();
+    }
+    printf("  20s of a 700ms blink across the millis() wrap: halves of "
+            "%u to %u ms\n", shortest, longest);
+    return shortest < 349 || longest > 351;
+}
+
+// The sketch's own stats lines, kept to be checked
+class string_print : public Print
+{
+    public:
+        std::string text;
+        size_t write(uint8_t c) { text += (char)c; return 1; }
+        using Print::write;
+};
+
+// Right button presses with contact bounce going down and coming up, and
+//  a one sample glitch to the Up reading between each, replayed through
+//  the ADC interrupt
+static int benchButtons() {
+    setup();
+    loopUntil(sim_clock() + 10000000ULL);
+    const uint8_t presses = 20;
+    uint64_t t = sim_clock() + 100000;
+    for (uint8_t i = 0; i < presses; i++, t += 500000) {
+        for (uint8_t b = 0; b < 6; b++)
+            sim_adc_trace(A0, t + b * 500, b & 1 ? 1023 : 500);
+        for (uint8_t b = 0; b < 6; b++)
+            sim_adc_trace(A0, t + 150000 + b * 500, b & 1 ? 500 : 1023);
+        sim_adc_trace(A0, t + 300000, 150);
+        sim_adc_trace(A0, t + 301000, 1023);
+    }
+    uint64_t busy = sim_devices[SIM_ADC].us;
+    uint32_t samples = sim_devices[SIM_ADC].calls;
+    loopUntil(t);
+    printf("buttons: %u bouncing presses of Right, glitches between\n",
+            presses);
+    printf("  %u ADC samples, %llu us blocked on the ADC\n",
+            sim_devices[SIM_ADC].calls - samples,
+            (unsigned long long)(sim_devices[SIM_ADC].us - busy));
+    string_print stats;
+    LCD_UI.printInputStats(stats);
+    printf("  %s", stats.text.c_str());
+    printf("  |%s|, home after a multiple of 4\n", sim_lcd_row(0));
+    // Each press is a down, three repeats in its 150ms and an up, the
+    //  glitches are nothing
+    unsigned events = 0, dropped = 0;
+    sscanf(stats.text.c_str(), "Buttons: events %u, dropped %u", &events,
+            &dropped);
+    bool right = events == presses * 5u && dropped == 0 &&
+            LCD_UI.isHomeScreen();
+    if (!right)
+        printf("  expected %u events, none dropped and the home screen\n",
+                presses * 5u);
+    return !right;
+}
+
+// The fixed windows five_btn::read() used to decode with
+static byte windowButton(int reading) {
+    if (reading > 730 && reading < 750) return five_btn::OK_BTN;
+    if (reading > 490 && reading < 510) return five_btn::RHT_BTN;
+    if (reading > 320 && reading < 340) return five_btn::DWN_BTN;
+    if (reading > 140 && reading < 160) return five_btn::UP_BTN;
+    if (reading > 0 && reading < 20) return five_btn::LFT_BTN;
+    return five_btn::NO_BTN;
+}
+
+// Both LCD rows, sim_lcd_row() reuses its buffer
+static void printScreen() {
+    printf("  |%s|", sim_lcd_row(0));
+    printf(" |%s|\n", sim_lcd_row(1));
+}
+
+// How the buttons of a unit reading drifted levels decode, and how many
+//  readings decode to a button at all
+static void printDecode(const char *name, byte (*decode)(int),
+        const int *drifted) {
+    uint16_t covered = 0;
+    for (int r = 0; r < 1024; r++)
+        covered += decode(r) != five_btn::NO_BTN;
+    printf("  %-12s %4u of 1024 readings are a button, drifted unit reads",
+            name, covered);
+    for (uint8_t b = 0; b < CONFIG_BUTTONS; b++)
+        printf(" %u", decode(drifted[b]));
+    printf("\n");
+}
+
+// A unit whose ladder reads well off the nominal levels, calibrated from
+//  the menu
+static int benchCalibrate() {
+    setup();
+    loopUntil(sim_clock() + 10000000ULL);
+    // OK, Up, Down, Left then Right, as the drifted unit reads them
+    static const int drifted[] = {610, 230, 400, 60, 520};
+    printf("calibrate: buttons 1 to 5 reading %d %d %d %d %d\n", drifted[0],
+            drifted[1], drifted[2], drifted[3], drifted[4]);
+    printDecode("windows", windowButton, drifted);
+    printDecode("nominal", five_btn::read, drifted);
+
+    // To Config, then Right to Calibrate Btns and OK, at nominal levels
+    const char *walk = "RRRXRRRRX";
+    static const char keys[] = "LRUDX";
+    static const int volts[] = {10, 500, 150, 330, 740};
+    for (const char *k = walk; *k; k++) {
+        sim_set_adc(A0, volts[strchr(keys, *k) - keys]);
+        loopUntil(sim_clock() + 200000);
+        sim_set_adc(A0, 1023);
+        loopUntil(sim_clock() + 200000);
+    }
+    printScreen();
+    // Each button as asked, bouncing on the way down, with some noise
+    uint64_t t = sim_clock() + 100000;
+    for (uint8_t b = 0; b < CONFIG_BUTTONS; b++, t += 600000) {
+        for (uint8_t i = 0; i < 6; i++)
+            sim_adc_trace(A0, t + i * 500, i & 1 ? 1023 : drifted[b]);
+        for (uint8_t i = 0; i < 100; i++)
+            sim_adc_trace(A0, t + 3000 + i * 2000, drifted[b] + (i % 3) - 1);
+        sim_adc_trace(A0, t + 300000, 1023);
+    }
+    for (uint8_t b = 0; b < CONFIG_BUTTONS; b++) {
+        loopUntil(sim_clock() + 600000);
+        printScreen();
+    }
+    loopUntil(t);
+    const uint8_t *levels = CONFIG.data.button_levels;
+    printf("  saved levels %u %u %u %u %u\n", levels[0], levels[1], levels[2],
+            levels[3], levels[4]);
+    printDecode("calibrated", five_btn::read, drifted);
+    // The new levels have to come back at the next boot
+    drainEeprom();
+    config_store config;
+    config.load(EEPROM_CONFIG);
+    printf("  after reboot %u %u %u %u %u\n", config.data.button_levels[0],
+            config.data.button_levels[1], config.data.button_levels[2],
+            config.data.button_levels[3], config.data.button_levels[4]);
+    // Buttons are numbered in calibration order, so each drifted reading
+    //  and its noise has to decode to the one it was pressed as
+    bool right = !memcmp(config.data.button_levels, levels, CONFIG_BUTTONS);
+    for (uint8_t b = 0; b < CONFIG_BUTTONS; b++)
+        for (int d = -1; d <= 1; d++)
+            if (five_btn::read(drifted[b] + d) != b + 1) {
+                printf("  reading %d decodes to %u, not %u\n", drifted[b] + d,
+                        five_btn::read(drifted[b] + d), b + 1);
+                right = false;
+            }
+    return !right;
+}
+
+// The conversions as they were, walking years and months one at a time
+static const uint8_t walk_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static uint8_t walkMonthDays(uint8_t year, uint8_t month) {
+    return month == 2 && year % 4 == 0 ? 29 : walk_days[month - 1];
+}
+
+static uint32_t walkToEpoch(const DateTime &ts) {
+    uint32_t days = ts.Year * 365UL + (ts.Year + 3) / 4;
+    for (uint8_t m = 1; m < ts.Month; m++)
+        days += walkMonthDays(ts.Year, m);
+    days += ts.Day - 1;
+    return ((days * 24 + ts.Hour) * 60 + ts.Minute) * 60 + ts.Second;
+}
+
+static DateTime walkFromEpoch(uint32_t seconds) {
+    DateTime ts;
+    ts.Second = seconds % 60;
+    uint32_t minutes = seconds / 60;
+    ts.Minute = minutes % 60;
+    uint32_t hours = minutes / 60;
+    ts.Hour = hours % 24;
+    uint16_t days = hours / 24;
+    ts.Dow = (days + 6) % 7 + 1;
+    ts.Year = (days / 1461) * 4;
+    days %= 1461;
+    while (days >= (ts.Year % 4 == 0 ? 366 : 365)) {
+        days -= (ts.Year % 4 == 0 ? 366 : 365);
+        ts.Year++;
+    }
+    ts.Month = 1;
+    while (days >= walkMonthDays(ts.Year, ts.Month)) {
+        days -= walkMonthDays(ts.Year, ts.Month);
+        ts.Month++;
+    }
+    ts.Day = days + 1;
+    return ts;
+}
+
+static bool sameTime(const DateTime &a, const DateTime &b) {
+    return a.Second == b.Second && a.Minute == b.Minute && a.Hour == b.Hour &&
+            a.Dow == b.Dow && a.Day == b.Day && a.Month == b.Month &&
+            a.Year == b.Year;
+}
+
+// Conversions a second both ways, over times spread across the century
+static int benchCalendar() {
+    const uint32_t n = 1 << 16;
+    static DateTime times[n];
+    for (uint32_t i = 0; i < n; i++)
+        times[i] = fromEpoch(i * 48157UL);
+    const unsigned long rounds = 200;
+    // Sums keep the compiler from dropping the work
+    uint32_t sum = 0;
+    printf("calendar: %lu conversions each way\n", rounds * n);
+    for (uint8_t walk = 0; walk < 2; walk++) {
+        bench_clock::time_point start = bench_clock::now();
+        for (unsigned long r = 0; r < rounds; r++)
+            for (uint32_t i = 0; i < n; i++)
+                sum += walk ? walkToEpoch(times[i]) : toEpoch(times[i]);
+        double to = secondsSince(start);
+        start = bench_clock::now();
+        for (unsigned long r = 0; r < rounds; r++)
+            for (uint32_t i = 0; i < n; i++)
+                sum += (walk ? walkFromEpoch(i * 48157UL + r) :
+                        fromEpoch(i * 48157UL + r)).Day;
+        double from = secondsSince(start);
+        printf("  %-12s toEpoch %6.1fM/s  fromEpoch %6.1fM/s\n",
+                walk ? "month walk" : "closed form", rounds * n / to / 1e6,
+                rounds * n / from / 1e6);
+    }
+    printf("  (checksum %u)\n", sum);
+    return 0;
+}
+
+// Every day from 2000 through 2099 at every minute, converted both ways
+//  and against the month walk, and every date checked for validity
+static int benchRoundTrip() {
+    uint32_t failures = 0, checked = 0;
+    uint8_t dow = 7; // 2000-01-01 was a Saturday
+    uint32_t days = 0;
+    for (uint8_t year = 0; year <= 99; year++)
+        for (uint8_t month = 1; month <= 12; month++)
+            for (uint8_t day = 1; day <= walkMonthDays(year, month); day++) {
+                for (uint16_t minute = 0; minute < 1440; minute++) {
+                    DateTime ts;
+                    ts.Year = year;
+                    ts.Month = month;
+                    ts.Day = day;
+                    ts.Hour = minute / 60;
+                    ts.Minute = minute % 60;
+                    ts.Second = (days + minute) % 60;
+                    ts.Dow = dow;
+                    uint32_t seconds = toEpoch(ts);
+                    checked++;
+                    if (seconds != days * SECONDS_PER_DAY + minute * 60UL +
+                            ts.Second || seconds != walkToEpoch(ts) ||
+                            !sameTime(fromEpoch(seconds), ts) ||
+                            !sameTime(walkFromEpoch(seconds), ts)) {
+                        if (failures++ < 10)
+                            printf("  mismatch at 20%02u-%02u-%02u %02u:%02u:%02u\n",
+                                    year, month, day, ts.Hour, ts.Minute,
+                                    ts.Second);
+                    }
+                }
+                days++;
+                dow = dow % 7 + 1;
+            }
+    // Every date the DS3231 can be asked for, and some it can't
+    uint32_t valid = 0, wrong = 0;
+    for (uint16_t year = 0; year <= 100; year++)
+        for (uint8_t month = 0; month <= 13; month++)
+            for (uint8_t day = 0; day <= 32; day++) {
+                bool expect = year <= 99 && month >= 1 && month <= 12 &&
+                        day >= 1 && day <= walkMonthDays(year, month);
+                bool got = validDate(year, month, day);
+                valid += got;
+                wrong += got != expect;
+            }
+    printf("roundtrip: %u days, %u times, %u mismatches\n", days, checked,
+            failures);
+    printf("  %u valid dates, %u misjudged\n", valid, wrong);
+    return failures || wrong || days != 36525 || valid != 36525;
+}
+
+int runBenchmark(const char *name) {
+    if (!strcmp(name, "parse"))
+        return benchParse();
+    if (!strcmp(name, "dispatch"))
+        return benchDispatch();
+    if (!strcmp(name, "output"))
+        return benchOutput();
+    if (!strcmp(name, "wear"))
+        return benchWear();
+    if (!strcmp(name, "fit"))
+        return benchFit();
+    if (!strcmp(name, "stats"))
+        return benchStats();
+    if (!strcmp(name, "cache"))
+        return benchCache();
+    if (!strcmp(name, "config"))
+        return benchConfig();
+    if (!strcmp(name, "lcd"))
+        return benchLcd();
+    if (!strcmp(name, "menu"))
+        return benchMenu();
+    if (!strcmp(name, "led"))
+        return benchLed();
+    if (!strcmp(name, "buttons"))
+        return benchButtons();
+    if (!strcmp(name, "calibrate"))
+        return benchCalibrate();
+    if (!strcmp(name, "calendar"))
+        return benchCalendar();
+    if (!strcmp(name, "roundtrip"))
+        return benchRoundTrip();
+    fprintf(stderr, "unknown benchmark: %s (parse, dispatch, output, wear, "
+            "fit, stats, cache, config, lcd, menu, led, buttons, calibrate, "
+            "calendar, roundtrip)\n", name);
+    return 2;
+}
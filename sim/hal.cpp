@@ -0,0 +1,792 @@
+// hal.cpp
+/* Host implementations of the stubbed Arduino core and libraries.
+        Costs are rough figures for a 16MHz Uno with the stock libraries and
+        are only meant to rank where the loop budget goes. */
+#include <deque>
+#include <stdio.h>
+#include <string>
+
+#include "sim_hal.h"
+#include <Arduino.h>
+#include <DS3231_Simple.h>
+#include <EEPROM.h>
+#include <Ethernet.h>
+#include <FastLED.h>
+#include <LiquidCrystal.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+
+#define EEPROM_SIZE (E2END + 1)
+#define SERIAL_TX_BUFFER 64
+#define SERIAL_RX_BUFFER 64
+
+// Modeled blocking costs in microseconds
+#define SERIAL_WRITE_US 5     // Buffer insert when there is room
+#define EEPROM_WRITE_US 3300  // Erase + write cycle
+#define DHT_PIN 8             // Same as dht_control.cpp
+#define RTC_READ_US 1000      // 7 register read at 100kHz I2C
+#define RTC_WRITE_US 900
+#define LCD_BYTE_US 265       // Two nibbles, 100us enable settle each
+#define LCD_CLEAR_US 2000     // Extra delay after clear/home
+#define LCD_BEGIN_US 50000
+#define LED_PIXEL_US 30       // 24 bits at 800kHz
+#define LED_LATCH_US 50
+#define ADC_READ_US 112
+#define NET_REG_US 20         // Single W5100 register access over SPI
+#define NET_PARSE_US 40
+#define NET_BYTE_US 12
+#define NET_SEND_US 200
+#define TIMER0_TICK_US 1024   // 64 prescale, 256 counts at 16MHz
+
+sim_device sim_devices[SIM_DEVICE_COUNT] = {
+    {"serial", 0, 0, 0},
+    {"eeprom", 0, 0, 0},
+    {"dht22", 0, 0, 0},
+    {"rtc/i2c", 0, 0, 0},
+    {"lcd", 0, 0, 0},
+    {"fastled", 0, 0, 0},
+    {"adc", 0, 0, 0},
+    {"ethernet", 0, 0, 0},
+    {"delay", 0, 0, 0},
+    {"idle", 0, 0, 0},
+};
+uint32_t sim_eeprom_wear[EEPROM_SIZE];
+uint32_t sim_eeprom_reads = 0;
+
+static uint64_t clock_us = 0;
+static uint64_t clock_offset_us = 0;
+static bool echo = false;
+
+uint64_t sim_clock() {
+    return clock_us;
+}
+
+static void deliverEdges(uint64_t, bool);
+static void deliverEeprom(uint64_t);
+static void deliverAdc(uint64_t);
+
+void sim_advance(uint32_t us) {
+    deliverEdges(clock_us + us, false);
+}
+
+void sim_charge(uint8_t dev, uint32_t us, uint32_t bytes) {
+    sim_devices[dev].calls++;
+    sim_devices[dev].bytes += bytes;
+    sim_devices[dev].us += us;
+    // FastLED bit-bangs with interrupts off
+    deliverEdges(clock_us + us, dev == SIM_LED);
+}
+
+void sim_set_wrap_offset(uint32_t ms) {
+    clock_offset_us = (0x100000000ULL - ms) * 1000;
+}
+
+void sim_set_echo(bool on) {
+    echo = on;
+}
+
+// ====== //
+// Core
+unsigned long millis() {
+    return (uint32_t)((clock_us + clock_offset_us) / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)(clock_us + clock_offset_us);
+}
+
+void delay(unsigned long ms) {
+    sim_charge(SIM_DELAY, ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    sim_charge(SIM_DELAY, us);
+}
+
+void sleep_mode() {
+    uint64_t now = clock_us + clock_offset_us;
+    sim_charge(SIM_IDLE, TIMER0_TICK_US - now % TIMER0_TICK_US);
+}
+
+static int adc_values[A0 + 6] = {0};
+static bool adc_set[A0 + 6] = {false};
+
+void sim_set_adc(uint8_t pin, int value) {
+    adc_values[pin] = value;
+    adc_set[pin] = true;
+}
+
+// ====== //
+// DHT22 data line. Holding it low for 1ms and releasing it queues the
+//  sensor's response as timed edges, fed to the pin change ISR as the
+//  virtual clock passes them.
+struct line_edge {
+    uint64_t at;
+    uint8_t level;
+};
+
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCMSK0 = 0;
+extern "C" void sim_pcint0_vect(void) __attribute__((weak));
+
+static std::deque<line_edge> dht_edges;
+static uint8_t dht_line = HIGH;
+static bool dht_driven_low = false;
+static uint64_t dht_low_since = 0;
+static bool in_isr = false;
+
+static void pushBit(uint64_t &t, bool one) {
+    dht_edges.push_back({t, HIGH});
+    t += one ? 70 : 27;
+    dht_edges.push_back({t, LOW});
+    t += 50;
+}
+
+static void dhtRespond() {
+    // Half hour swing from 18C to 34C so every alarm gate gets crossed
+    double secs = clock_us / 1e6;
+    int16_t temp = round(10 * (26.0 + 8.0 * sin(secs * 2 * M_PI / 1800.0)));
+    uint16_t humid = round(10 * (45.0 + 10.0 * cos(secs * 2 * M_PI / 3600.0)));
+    uint16_t raw_temp = temp < 0 ? (0x8000 | -temp) : temp;
+    byte frame[5] = {highByte(humid), lowByte(humid), highByte(raw_temp), lowByte(raw_temp)};
+    frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+
+    uint64_t t = clock_us + 30;
+    dht_edges.push_back({t, LOW});
+    t += 80;
+    dht_edges.push_back({t, HIGH});
+    t += 80;
+    dht_edges.push_back({t, LOW});
+    t += 50;
+    for (uint8_t bit = 0; bit < 40; bit++)
+        pushBit(t, frame[bit >> 3] & (0x80 >> (bit & 7)));
+    // Sensor lets go of the line
+    dht_edges.push_back({t, HIGH});
+    sim_charge(SIM_DHT, 0, 5);
+}
+
+static void deliverEdges(uint64_t until, bool masked) {
+    bool pending = false;
+    while (!dht_edges.empty() && dht_edges.front().at <= until) {
+        if (!masked)
+            clock_us = max(clock_us, dht_edges.front().at);
+        dht_line = dht_edges.front().level;
+        dht_edges.pop_front();
+        bool enabled = (PCICR & _BV(PCIE0)) && (PCMSK0 & _BV(DHT_PIN - 8));
+        // A masked change only leaves the flag set, the rest are lost
+        if (enabled && masked)
+            pending = true;
+        else if (enabled && !in_isr && sim_pcint0_vect) {
+            in_isr = true;
+            sim_pcint0_vect();
+            in_isr = false;
+        }
+    }
+    if (!masked) {
+        deliverEeprom(until);
+        deliverAdc(until);
+    }
+    clock_us = until;
+    if (pending && sim_pcint0_vect) {
+        in_isr = true;
+        sim_pcint0_vect();
+        in_isr = false;
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin != DHT_PIN)
+        return;
+    if (mode != OUTPUT && dht_driven_low) {
+        dht_driven_low = false;
+        dht_line = HIGH;
+        if (clock_us - dht_low_since >= 1000)
+            dhtRespond();
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin != DHT_PIN)
+        return;
+    if (val == LOW && !dht_driven_low) {
+        dht_driven_low = true;
+        dht_low_since = clock_us;
+    }
+    dht_line = val;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin == DHT_PIN ? dht_line : LOW;
+}
+
+// ====== //
+// ADC conversions auto-triggered by timer0, and recorded input to feed them
+struct adc_step {
+    uint64_t at;
+    uint8_t pin;
+    int value;
+};
+
+volatile uint8_t ADMUX = 0;
+volatile uint8_t ADCSRA = 0;
+volatile uint8_t ADCSRB = 0;
+volatile uint8_t DIDR0 = 0;
+volatile uint16_t ADC = 0;
+extern "C" void sim_adc_vect(void) __attribute__((weak));
+
+static std::deque<adc_step> adc_steps;
+static uint64_t adc_last = 0;
+
+void sim_adc_trace(uint8_t pin, uint64_t at, int value) {
+    adc_steps.push_back({at, pin, value});
+}
+
+static void applyAdcTrace(uint64_t until) {
+    while (!adc_steps.empty() && adc_steps.front().at <= until) {
+        sim_set_adc(adc_steps.front().pin, adc_steps.front().value);
+        adc_steps.pop_front();
+    }
+}
+
+// Runs ADC_vect for each timer0 overflow before until. Overflows that came
+//  while the CPU was held up only leave the one flag set.
+static void deliverAdc(uint64_t until) {
+    uint8_t on = _BV(ADEN) | _BV(ADATE) | _BV(ADIE);
+    if ((ADCSRA & on) != on || ADCSRB != _BV(ADTS2) || !sim_adc_vect ||
+            in_isr) {
+        applyAdcTrace(until);
+        return;
+    }
+    uint64_t at = (adc_last / TIMER0_TICK_US + 1) * TIMER0_TICK_US;
+    if (at + TIMER0_TICK_US <= clock_us)
+        at = clock_us / TIMER0_TICK_US * TIMER0_TICK_US;
+    for (; at <= until; at += TIMER0_TICK_US) {
+        clock_us = max(clock_us, at);
+        applyAdcTrace(at);
+        uint8_t pin = A0 + (ADMUX & 0x07);
+        ADC = adc_set[pin] ? adc_values[pin] : 1023;
+        adc_last = at;
+        sim_devices[SIM_ADC].calls++;
+        in_isr = true;
+        sim_adc_vect();
+        in_isr = false;
+    }
+    applyAdcTrace(until);
+}
+
+int analogRead(uint8_t pin) {
+    sim_charge(SIM_ADC, ADC_READ_US);
+    applyAdcTrace(clock_us);
+    // Floating input reads high, like the button ladder with nothing pressed
+    return adc_set[pin] ? adc_values[pin] : 1023;
+}
+
+// ====== //
+// Print, same formatting rules as the AVR core
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (write(*buffer++)) n++;
+        else break;
+    }
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2) base = 10;
+    do {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+    size_t n = 0;
+    if (isnan(number)) return print("nan");
+    if (isinf(number)) return print("inf");
+    if (number < 0.0) {
+        n += print('-');
+        number = -number;
+    }
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i)
+        rounding /= 10.0;
+    number += rounding;
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += print(int_part);
+    if (digits > 0)
+        n += print('.');
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int to_print = (unsigned int)remainder;
+        n += print(to_print);
+        remainder -= to_print;
+    }
+    return n;
+}
+
+// The AVR core reads flash strings a byte at a time, so they never reach
+//  the bulk write
+size_t Print::print(const __FlashStringHelper *s) {
+    const char *p = reinterpret_cast<const char *>(s);
+    size_t n = 0;
+    while (*p) {
+        if (write((uint8_t)*p++)) n++;
+        else break;
+    }
+    return n;
+}
+size_t Print::print(const char s[]) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char b, int base) { return print((unsigned long)b, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(long n, int base) {
+    if (base == 0)
+        return write((uint8_t)n);
+    if (base == 10 && n < 0) {
+        int t = print('-');
+        return printNumber(-n, 10) + t;
+    }
+    return printNumber(n, base);
+}
+size_t Print::print(unsigned long n, int base) {
+    if (base == 0) return write((uint8_t)n);
+    return printNumber(n, base);
+}
+size_t Print::print(double n, int digits) { return printFloat(n, digits); }
+
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper *s) { return print(s) + println(); }
+size_t Print::println(const char s[]) { return print(s) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char b, int base) { return print(b, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits) { return print(n, digits) + println(); }
+
+// ====== //
+// Serial, modeled as the 64 byte TX ring drained by the UART at the baud rate
+HardwareSerial Serial;
+
+static uint32_t serial_byte_us = 1042;
+static uint8_t tx_level = 0;
+static uint64_t tx_drained_at = 0;
+static std::deque<uint8_t> rx_queue;
+
+static void serialDrain() {
+    while (tx_level && clock_us - tx_drained_at >= serial_byte_us) {
+        tx_level--;
+        tx_drained_at += serial_byte_us;
+    }
+    if (!tx_level)
+        tx_drained_at = clock_us;
+}
+
+void sim_serial_inject(const char *s) {
+    while (*s)
+        rx_queue.push_back((uint8_t)*s++);
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    // 8N1 frame is 10 bits
+    serial_byte_us = 10000000UL / baud;
+}
+
+int HardwareSerial::available() {
+    return min(rx_queue.size(), (size_t)SERIAL_RX_BUFFER);
+}
+
+int HardwareSerial::read() {
+    if (rx_queue.empty()) return -1;
+    uint8_t c = rx_queue.front();
+    rx_queue.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return rx_queue.empty() ? -1 : rx_queue.front();
+}
+
+int HardwareSerial::availableForWrite() {
+    serialDrain();
+    return SERIAL_TX_BUFFER - 1 - tx_level;
+}
+
+void HardwareSerial::flush() {
+    serialDrain();
+    if (tx_level)
+        sim_charge(SIM_SERIAL, tx_drained_at + tx_level * serial_byte_us - clock_us);
+    serialDrain();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    serialDrain();
+    if (tx_level == SERIAL_TX_BUFFER - 1) {
+        // Ring is full, spin until the UART frees a slot
+        sim_charge(SIM_SERIAL, tx_drained_at + serial_byte_us - clock_us, 1);
+        serialDrain();
+    }
+    else
+        sim_charge(SIM_SERIAL, SERIAL_WRITE_US, 1);
+    tx_level++;
+    if (echo)
+        putchar(c);
+    return 1;
+}
+
+// ====== //
+// EEPROM
+EEPROMClass EEPROM;
+
+static uint8_t eeprom_cells[EEPROM_SIZE];
+static bool eeprom_blank = true;
+
+static uint8_t *eepromCell(int idx) {
+    // Fresh chips read back erased
+    if (eeprom_blank) {
+        memset(eeprom_cells, 0xFF, sizeof(eeprom_cells));
+        eeprom_blank = false;
+    }
+    return &eeprom_cells[idx & E2END];
+}
+
+// End of the write the registers started, the library waits it out
+static uint64_t ee_busy_until = 0;
+static bool ee_started = false;
+sim_eecr_reg EECR = {0};
+volatile uint16_t EEAR = 0;
+volatile uint8_t EEDR = 0;
+extern "C" void sim_ee_ready_vect(void) __attribute__((weak));
+
+// Spins on EEPE like avr-libc. With EERIE set EE_READY starts the next
+//  queued byte as each one finishes, so the spin lasts until the queue is
+//  empty, not just the byte in flight.
+static void eepromWait() {
+    while (clock_us < ee_busy_until)
+        sim_charge(SIM_EEPROM, ee_busy_until - clock_us);
+}
+
+void eeprom_busy_wait() {
+    eepromWait();
+}
+
+sim_eecr_reg::operator uint8_t() const {
+    return bits | (clock_us < ee_busy_until ? _BV(EEPE) : 0);
+}
+
+sim_eecr_reg &sim_eecr_reg::operator|=(uint8_t v) {
+    bits |= v;
+    if (bits & _BV(EERE)) {
+        EEDR = *eepromCell(EEAR);
+        sim_eeprom_reads++;
+        bits &= ~_BV(EERE);
+    }
+    if (bits & _BV(EEPE)) {
+        if (bits & _BV(EEMPE)) {
+            *eepromCell(EEAR) = EEDR;
+            sim_eeprom_wear[EEAR & E2END]++;
+            sim_devices[SIM_EEPROM].calls++;
+            sim_devices[SIM_EEPROM].bytes++;
+            ee_busy_until = clock_us + EEPROM_WRITE_US;
+            ee_started = true;
+        }
+        bits &= ~(_BV(EEPE) | _BV(EEMPE));
+    }
+    return *this;
+}
+
+// Runs EE_READY each time the EEPROM comes free before until. Writes the
+//  handler starts run alongside the CPU rather than blocking it.
+static void deliverEeprom(uint64_t until) {
+    while ((EECR & _BV(EERIE)) && sim_ee_ready_vect && !in_isr) {
+        uint64_t at = max(ee_busy_until, clock_us);
+        if (at > until)
+            break;
+        ee_started = false;
+        in_isr = true;
+        sim_ee_ready_vect();
+        in_isr = false;
+        if (!ee_started)
+            break;
+        ee_busy_until = at + EEPROM_WRITE_US;
+    }
+}
+
+uint8_t EEPROMClass::read(int idx) {
+    eepromWait();
+    sim_eeprom_reads++;
+    return *eepromCell(idx);
+}
+
+void EEPROMClass::write(int idx, uint8_t val) {
+    eepromWait();
+    *eepromCell(idx) = val;
+    sim_eeprom_wear[idx & E2END]++;
+    sim_charge(SIM_EEPROM, EEPROM_WRITE_US, 1);
+}
+
+void EEPROMClass::update(int idx, uint8_t val) {
+    if (read(idx) != val)
+        write(idx, val);
+}
+
+// ====== //
+// DS3231, epoch is seconds since 2000-01-01 (a Saturday)
+static const uint8_t month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+// 2026-10-17 08:00:00
+static uint32_t rtc_base = 845539200UL;
+
+static uint8_t daysInMonth(uint8_t year, uint8_t month) {
+    return (month == 2 && year % 4 == 0) ? 29 : month_days[month - 1];
+}
+
+static uint32_t toEpoch(const DateTime &ts) {
+    uint32_t days = ts.Year * 365UL + (ts.Year + 3) / 4;
+    for (uint8_t m = 1; m < ts.Month; m++)
+        days += daysInMonth(ts.Year, m);
+    days += ts.Day - 1;
+    return ((days * 24UL + ts.Hour) * 60 + ts.Minute) * 60 + ts.Second;
+}
+
+static DateTime fromEpoch(uint32_t s) {
+    DateTime ts;
+    ts.Second = s % 60; s /= 60;
+    ts.Minute = s % 60; s /= 60;
+    ts.Hour = s % 24; s /= 24;
+    // Day 0 was a Saturday, DS3231 counts Sunday as 1
+    ts.Dow = (s + 6) % 7 + 1;
+    ts.Year = 0;
+    while (s >= (ts.Year % 4 == 0 ? 366u : 365u)) {
+        s -= (ts.Year % 4 == 0 ? 366 : 365);
+        ts.Year++;
+    }
+    ts.Month = 1;
+    while (s >= daysInMonth(ts.Year, ts.Month)) {
+        s -= daysInMonth(ts.Year, ts.Month);
+        ts.Month++;
+    }
+    ts.Day = s + 1;
+    return ts;
+}
+
+static void print2(Print &p, uint8_t v) {
+    if (v < 10) p.print('0');
+    p.print(v);
+}
+
+void DS3231_Simple::begin() {}
+
+DateTime DS3231_Simple::read() {
+    sim_charge(SIM_RTC, RTC_READ_US, 8);
+    return fromEpoch(rtc_base + clock_us / 1000000);
+}
+
+uint8_t DS3231_Simple::write(const DateTime &ts) {
+    sim_charge(SIM_RTC, RTC_WRITE_US, 8);
+    rtc_base = toEpoch(ts) - clock_us / 1000000;
+    return 1;
+}
+
+void DS3231_Simple::printDateTo_YMD(Print &p, const char sep) {
+    printDateTo_YMD(p, read(), sep);
+}
+
+void DS3231_Simple::printDateTo_YMD(Print &p, const DateTime &ts, const char sep) {
+    p.print(F("20"));
+    print2(p, ts.Year);
+    p.print(sep);
+    print2(p, ts.Month);
+    p.print(sep);
+    print2(p, ts.Day);
+}
+
+void DS3231_Simple::printTimeTo_HMS(Print &p, const char hm, const char ms) {
+    printTimeTo_HMS(p, read(), hm, ms);
+}
+
+void DS3231_Simple::printTimeTo_HMS(Print &p, const DateTime &ts, const char hm,
+        const char ms) {
+    print2(p, ts.Hour);
+    p.print(hm);
+    print2(p, ts.Minute);
+    p.print(ms);
+    print2(p, ts.Second);
+}
+
+// ====== //
+// FastLED
+CFastLED FastLED;
+
+void CFastLED::show() {
+    sim_charge(SIM_LED, LED_LATCH_US + num_leds * LED_PIXEL_US, num_leds * 3);
+}
+
+// ====== //
+// LiquidCrystal, display RAM is 40 characters a row
+static char lcd_ram[2][41];
+
+const char *sim_lcd_row(uint8_t r) {
+    static char text[17];
+    memcpy(text, lcd_ram[r & 1], 16);
+    text[16] = 0;
+    return text;
+}
+
+void LiquidCrystal::begin(uint8_t c, uint8_t r) {
+    cols = c;
+    rows = r;
+    memset(lcd_ram, ' ', sizeof(lcd_ram));
+    sim_charge(SIM_LCD, LCD_BEGIN_US, 6);
+}
+
+void LiquidCrystal::command(uint8_t) {
+    sim_charge(SIM_LCD, LCD_BYTE_US, 1);
+}
+
+void LiquidCrystal::clear() {
+    sim_charge(SIM_LCD, LCD_BYTE_US + LCD_CLEAR_US, 1);
+    memset(lcd_ram, ' ', sizeof(lcd_ram));
+    col = row = 0;
+}
+
+void LiquidCrystal::home() {
+    sim_charge(SIM_LCD, LCD_BYTE_US + LCD_CLEAR_US, 1);
+    col = row = 0;
+}
+
+void LiquidCrystal::setCursor(uint8_t c, uint8_t r) {
+    col = c;
+    row = r < rows ? r : rows - 1;
+    command(0x80 | (col + row * 0x40));
+}
+
+void LiquidCrystal::createChar(uint8_t, const uint8_t *) {
+    sim_charge(SIM_LCD, LCD_BYTE_US * 9, 9);
+}
+
+size_t LiquidCrystal::write(uint8_t c) {
+    sim_charge(SIM_LCD, LCD_BYTE_US, 1);
+    if (col < 40)
+        lcd_ram[row][col] = c;
+    col++;
+    return 1;
+}
+
+// ====== //
+// Ethernet
+EthernetClass Ethernet;
+
+static std::deque<std::string> udp_inbox;
+static std::string udp_packet;
+static size_t udp_read_pos = 0;
+
+void sim_udp_inject(const char *data, size_t len) {
+    udp_inbox.push_back(std::string(data, len));
+}
+
+void EthernetClass::begin(uint8_t *, IPAddress) {
+    sim_charge(SIM_NET, NET_REG_US * 20);
+}
+
+EthernetLinkStatus EthernetClass::linkStatus() {
+    sim_charge(SIM_NET, NET_REG_US);
+    return LinkON;
+}
+
+EthernetHardwareStatus EthernetClass::hardwareStatus() {
+    sim_charge(SIM_NET, NET_REG_US);
+    return EthernetW5100;
+}
+
+uint8_t EthernetUDP::begin(uint16_t) {
+    sim_charge(SIM_NET, NET_REG_US * 4);
+    return 1;
+}
+
+int EthernetUDP::parsePacket() {
+    sim_charge(SIM_NET, NET_PARSE_US);
+    if (udp_inbox.empty())
+        return 0;
+    udp_packet = udp_inbox.front();
+    udp_inbox.pop_front();
+    udp_read_pos = 0;
+    remote_ip = IPAddress(192, 168, 1, 50);
+    remote_port = 9999;
+    return udp_packet.size();
+}
+
+int EthernetUDP::available() {
+    return udp_packet.size() - udp_read_pos;
+}
+
+int EthernetUDP::read() {
+    if (!available()) return -1;
+    sim_charge(SIM_NET, NET_BYTE_US, 1);
+    return (uint8_t)udp_packet[udp_read_pos++];
+}
+
+int EthernetUDP::read(unsigned char *buffer, size_t len) {
+    size_t n = min(len, (size_t)available());
+    memcpy(buffer, udp_packet.data() + udp_read_pos, n);
+    udp_read_pos += n;
+    sim_charge(SIM_NET, NET_BYTE_US * n, n);
+    return n;
+}
+
+int EthernetUDP::peek() {
+    return available() ? (uint8_t)udp_packet[udp_read_pos] : -1;
+}
+
+// Binary replies, told apart by their non-ASCII first byte, are echoed
+//  as hex so they stay readable
+static int echo_pos = 0;
+static bool echo_hex = false;
+
+int EthernetUDP::beginPacket(IPAddress, uint16_t) {
+    sim_charge(SIM_NET, NET_REG_US * 3);
+    echo_pos = 0;
+    if (echo)
+        fputs("[udp> ", stdout);
+    return 1;
+}
+
+int EthernetUDP::endPacket() {
+    sim_charge(SIM_NET, NET_SEND_US);
+    if (echo)
+        fputs("]\n", stdout);
+    return 1;
+}
+
+static void echoByte(uint8_t c) {
+    if (echo_pos++ == 0)
+        echo_hex = c >= 0x80;
+    if (echo_hex)
+        printf("%s%02x", echo_pos > 1 ? " " : "", c);
+    else
+        putchar(c);
+}
+
+// The library sends a lone byte through the same buffer update as a block
+size_t EthernetUDP::write(uint8_t c) {
+    sim_charge(SIM_NET, NET_REG_US + NET_BYTE_US, 1);
+    if (echo)
+        echoByte(c);
+    return 1;
+}
+
+size_t EthernetUDP::write(const uint8_t *buffer, size_t size) {
+    sim_charge(SIM_NET, NET_REG_US + NET_BYTE_US * size, size);
+    if (echo)
+        for (size_t i = 0; i < size; i++)
+            echoByte(buffer[i]);
+    return size;
+}
@@ -0,0 +1,189 @@
+// Arduino.h
+/* Host stand-in for the Arduino AVR core used by the simulation build.
+        Only covers what the sketch actually calls. Anything that blocks on
+        real hardware charges its modeled cost to the virtual clock in hal.cpp */
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define A0 14
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+// No separate flash address space on the host
+#define PROGMEM
+#define PGM_P const char *
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strncmp_P strncmp
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) \
+    ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint16_t makeWord(uint8_t h, uint8_t l) { return (h << 8) | l; }
+#define word(...) makeWord(__VA_ARGS__)
+
+#define _BV(bit) (1 << (bit))
+
+// Interrupts are delivered by hal.cpp between modeled costs
+#define ISR(vector, ...) extern "C" void vector(void)
+#define PCINT0_vect sim_pcint0_vect
+#define noInterrupts()
+#define interrupts()
+
+// EEPROM registers. Setting EERE reads EEAR into EEDR and setting EEPE
+//  (after EEMPE) starts a write that keeps the EEPROM busy for its cycle,
+//  reading back EEPE until then. EE_READY fires whenever EERIE is set and
+//  no write is in progress.
+struct sim_eecr_reg {
+    uint8_t bits;
+    operator uint8_t() const;
+    sim_eecr_reg &operator|=(uint8_t);
+    sim_eecr_reg &operator&=(uint8_t v) { bits &= v; return *this; }
+};
+extern sim_eecr_reg EECR;
+extern volatile uint16_t EEAR;
+extern volatile uint8_t EEDR;
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define EE_READY_vect sim_ee_ready_vect
+
+// Pin change interrupt registers, only PORTB (pins 8-13) is modeled
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK0;
+#define PCIE0 0
+#define digitalPinToPCICR(p) (&PCICR)
+#define digitalPinToPCICRbit(p) (PCIE0)
+#define digitalPinToPCMSK(p) (&PCMSK0)
+#define digitalPinToPCMSKbit(p) ((p) - 8)
+
+// ADC registers, only what auto-triggered conversions need. While ADEN,
+//  ADATE and ADIE are set and ADCSRB picks timer0 overflow, ADC_vect runs
+//  every timer0 tick with the channel in ADMUX sampled into ADC.
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint8_t DIDR0;
+extern volatile uint16_t ADC;
+#define REFS0 6
+#define ADEN 7
+#define ADATE 5
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define ADTS2 2
+#define ADC0D 0
+#define ADC_vect sim_adc_vect
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+int analogRead(uint8_t);
+
+inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+inline bool isSpace(int c) { return isspace(c) != 0; }
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class Print
+{
+    private:
+        size_t printNumber(unsigned long, uint8_t);
+        size_t printFloat(double, uint8_t);
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t) = 0;
+        virtual size_t write(const uint8_t *, size_t);
+        size_t write(const char *str) {
+            if (str == NULL) return 0;
+            return write((const uint8_t *)str, strlen(str));
+        }
+        size_t write(const char *buffer, size_t size) {
+            return write((const uint8_t *)buffer, size);
+        }
+        virtual int availableForWrite() { return 0; }
+        virtual void flush() {}
+
+        size_t print(const __FlashStringHelper *);
+        size_t print(const char[]);
+        size_t print(char);
+        size_t print(unsigned char, int = DEC);
+        size_t print(int, int = DEC);
+        size_t print(unsigned int, int = DEC);
+        size_t print(long, int = DEC);
+        size_t print(unsigned long, int = DEC);
+        size_t print(double, int = 2);
+
+        size_t println(const __FlashStringHelper *);
+        size_t println(const char[]);
+        size_t println(char);
+        size_t println(unsigned char, int = DEC);
+        size_t println(int, int = DEC);
+        size_t println(unsigned int, int = DEC);
+        size_t println(long, int = DEC);
+        size_t println(unsigned long, int = DEC);
+        size_t println(double, int = 2);
+        size_t println();
+};
+
+class Stream : public Print
+{
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+};
+
+class HardwareSerial : public Stream
+{
+    public:
+        void begin(unsigned long);
+        int available();
+        int read();
+        int peek();
+        int availableForWrite();
+        void flush();
+        size_t write(uint8_t);
+        using Print::write;
+        operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,33 @@
+// DS3231_Simple.h
+/* Host stand-in for the DS3231_Simple RTC library. The clock runs off the
+        virtual clock and every read or write is charged as an I2C transfer. */
+#ifndef SIM_DS3231_SIMPLE_H
+#define SIM_DS3231_SIMPLE_H
+
+#include <Arduino.h>
+
+struct DateTime {
+    uint8_t Second;
+    uint8_t Minute;
+    uint8_t Hour;
+    uint8_t Dow;
+    uint8_t Day;
+    uint8_t Month;
+    uint8_t Year;
+};
+
+class DS3231_Simple
+{
+    public:
+        void begin();
+        DateTime read();
+        uint8_t write(const DateTime &);
+
+        void printDateTo_YMD(Print &, const char = '-');
+        void printDateTo_YMD(Print &, const DateTime &, const char = '-');
+        void printTimeTo_HMS(Print &, const char = ':', const char = ':');
+        void printTimeTo_HMS(Print &, const DateTime &, const char = ':',
+                const char = ':');
+};
+
+#endif
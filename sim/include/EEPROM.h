@@ -0,0 +1,37 @@
+// EEPROM.h
+/* Host stand-in for the AVR EEPROM library. 1KB like the Uno, addresses
+        wrap the same way the EEAR register does. */
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <Arduino.h>
+
+#define E2END 0x3FF
+
+class EEPROMClass
+{
+    public:
+        uint8_t read(int);
+        void write(int, uint8_t);
+        // Only writes (and only costs time) if the value differs
+        void update(int, uint8_t);
+        uint16_t length() { return E2END + 1; }
+
+        template <typename T> T &get(int idx, T &t) {
+            uint8_t *ptr = (uint8_t *)&t;
+            for (size_t i = 0; i < sizeof(T); i++)
+                ptr[i] = read(idx + i);
+            return t;
+        }
+
+        template <typename T> const T &put(int idx, const T &t) {
+            const uint8_t *ptr = (const uint8_t *)&t;
+            for (size_t i = 0; i < sizeof(T); i++)
+                update(idx + i, ptr[i]);
+            return t;
+        }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,63 @@
+// Ethernet.h
+/* Host stand-in for the W5100/W5500 Ethernet library. Incoming UDP packets
+        are injected by the simulation driver. */
+#ifndef SIM_ETHERNET_H
+#define SIM_ETHERNET_H
+
+#include <Arduino.h>
+
+#define UDP_TX_PACKET_MAX_SIZE 24
+
+class IPAddress
+{
+    private:
+        uint8_t bytes[4];
+    public:
+        IPAddress() { memset(bytes, 0, sizeof(bytes)); }
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+            bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d;
+        }
+        uint8_t operator[](int i) const { return bytes[i]; }
+        uint8_t &operator[](int i) { return bytes[i]; }
+        bool operator==(const IPAddress &o) const {
+            return memcmp(bytes, o.bytes, sizeof(bytes)) == 0;
+        }
+};
+
+enum EthernetLinkStatus { Unknown, LinkON, LinkOFF };
+enum EthernetHardwareStatus { EthernetNoHardware, EthernetW5100, EthernetW5200, EthernetW5500 };
+
+class EthernetClass
+{
+    public:
+        void init(uint8_t) {}
+        void begin(uint8_t *, IPAddress);
+        EthernetLinkStatus linkStatus();
+        EthernetHardwareStatus hardwareStatus();
+};
+
+extern EthernetClass Ethernet;
+
+class EthernetUDP : public Stream
+{
+    private:
+        IPAddress remote_ip;
+        uint16_t remote_port = 0;
+    public:
+        uint8_t begin(uint16_t);
+        int parsePacket();
+        int available();
+        int read();
+        int read(unsigned char *, size_t);
+        int read(char *buffer, size_t len) { return read((unsigned char *)buffer, len); }
+        int peek();
+        int beginPacket(IPAddress, uint16_t);
+        int endPacket();
+        size_t write(uint8_t);
+        size_t write(const uint8_t *, size_t);
+        using Print::write;
+        IPAddress remoteIP() { return remote_ip; }
+        uint16_t remotePort() { return remote_port; }
+};
+
+#endif
@@ -0,0 +1,52 @@
+// FastLED.h
+/* Host stand-in for FastLED. show() is charged at WS2812 wire speed. */
+#ifndef SIM_FASTLED_H
+#define SIM_FASTLED_H
+
+#include <Arduino.h>
+
+struct CRGB {
+    union {
+        struct { uint8_t r, g, b; };
+        struct { uint8_t red, green, blue; };
+        uint8_t raw[3];
+    };
+
+    typedef enum {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Green = 0x008000,
+        Red = 0xFF0000,
+        White = 0xFFFFFF
+    } HTMLColorCode;
+
+    CRGB() {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(HTMLColorCode c) : r((c >> 16) & 0xFF), g((c >> 8) & 0xFF), b(c & 0xFF) {}
+
+    bool operator==(const CRGB &o) const {
+        return r == o.r && g == o.g && b == o.b;
+    }
+    bool operator!=(const CRGB &o) const { return !(*this == o); }
+};
+
+template <uint8_t DATA_PIN> class NEOPIXEL {};
+
+class CFastLED
+{
+    private:
+        CRGB *leds = NULL;
+        int num_leds = 0;
+    public:
+        template <template <uint8_t> class CHIPSET, uint8_t DATA_PIN>
+        void addLeds(CRGB *data, int n) {
+            leds = data;
+            num_leds = n;
+        }
+        void show();
+        const CRGB *getLeds() { return leds; }
+};
+
+extern CFastLED FastLED;
+
+#endif
@@ -0,0 +1,28 @@
+// LiquidCrystal.h
+/* Host stand-in for the HD44780 LiquidCrystal library. Every byte sent to
+        the controller is charged and counted, and characters land in a
+        model of its display RAM that sim_lcd_row() reads back. */
+#ifndef SIM_LIQUIDCRYSTAL_H
+#define SIM_LIQUIDCRYSTAL_H
+
+#include <Arduino.h>
+
+class LiquidCrystal : public Print
+{
+    private:
+        uint8_t cols = 16, rows = 2;
+        uint8_t col = 0, row = 0;
+    public:
+        LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+
+        void begin(uint8_t, uint8_t);
+        void clear();
+        void home();
+        void setCursor(uint8_t, uint8_t);
+        void createChar(uint8_t, const uint8_t *);
+        void command(uint8_t);
+        size_t write(uint8_t);
+        using Print::write;
+};
+
+#endif
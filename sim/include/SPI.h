@@ -0,0 +1,8 @@
+// SPI.h
+/* Host stand-in. The Ethernet stub charges SPI time itself. */
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,8 @@
+// Wire.h
+/* Host stand-in. The DS3231 stub charges I2C time itself. */
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+#endif
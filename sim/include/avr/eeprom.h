@@ -0,0 +1,10 @@
+// avr/eeprom.h
+/* Host stand-in for the part of avr-libc's EEPROM header the sketch uses
+        directly. The wait is on the virtual clock, see hal.cpp. */
+#ifndef SIM_AVR_EEPROM_H
+#define SIM_AVR_EEPROM_H
+
+// Spin until EEPE clears. EE_READY still runs meanwhile if EERIE is set.
+void eeprom_busy_wait();
+
+#endif
@@ -0,0 +1,14 @@
+// avr/sleep.h
+/* Host stand-in for the AVR sleep modes. Idle sleep lasts until the next
+        timer0 overflow, which is what wakes the real chip every ~1ms. */
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(uint8_t) {}
+void sleep_mode();
+
+#endif
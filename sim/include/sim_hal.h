@@ -0,0 +1,52 @@
+// sim_hal.h
+/* Controls for the simulated hardware: the virtual clock, input injection
+        and the per-device cost accounting read back by sim_main.cpp */
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum sim_device_id {
+    SIM_SERIAL,
+    SIM_EEPROM,
+    SIM_DHT,
+    SIM_RTC,
+    SIM_LCD,
+    SIM_LED,
+    SIM_ADC,
+    SIM_NET,
+    SIM_DELAY,
+    SIM_IDLE,
+    SIM_DEVICE_COUNT
+};
+
+struct sim_device {
+    const char *name;
+    uint32_t calls;  // Operations issued to the device
+    uint32_t bytes;  // Bytes moved over its bus or written to it
+    uint64_t us;     // Time the CPU spent blocked on it
+};
+
+extern sim_device sim_devices[SIM_DEVICE_COUNT];
+extern uint32_t sim_eeprom_wear[];
+extern uint32_t sim_eeprom_reads;
+
+// Virtual clock, in microseconds since boot
+uint64_t sim_clock();
+void sim_advance(uint32_t);
+void sim_charge(uint8_t, uint32_t, uint32_t = 0);
+// Start the clock this many ms before millis() wraps
+void sim_set_wrap_offset(uint32_t);
+
+void sim_serial_inject(const char *);
+void sim_udp_inject(const char *, size_t);
+void sim_set_adc(uint8_t, int);
+// Set an analog pin to a value once the clock reaches the given us, calls
+//  must come in time order
+void sim_adc_trace(uint8_t, uint64_t, int);
+void sim_set_echo(bool);
+// What the LCD shows on a row, 16 characters
+const char *sim_lcd_row(uint8_t);
+
+#endif
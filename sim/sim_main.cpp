@@ -0,0 +1,154 @@
+// sim_main.cpp
+/*
+    Drives the sketch's setup() and loop() on the virtual clock and reports
+    how long each loop() pass would have kept the CPU busy on the bench.
+    Time spent asleep waiting for the next deadline is not counted.
+
+    Usage: sim [-t seconds] [-w seconds] [-c "command"]... [-u "command"]...
+               [-a trace] [-v]
+           sim -b benchmark
+        -t  Virtual time to run for (default 600)
+        -w  Start the clock this many seconds before millis() wraps
+        -c  Type a command into Serial, one per second after boot
+        -u  Send a command as a UDP packet, one per second after boot
+        -a  Replay button ladder readings, "ms value" per line, ms since
+            power on in rising order
+        -v  Echo Serial and UDP output to stdout
+        -b  Run one of the host benchmarks in bench.cpp instead
+*/
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "sim_hal.h"
+
+// Time the AVR spends walking the poll chain itself, on top of device costs
+#define LOOP_OVERHEAD_US 20
+#define A0_PIN 14  // A0 in the stub Arduino.h, the button ladder
+
+void setup();
+void loop();
+int runBenchmark(const char*);
+
+struct scripted_input {
+    uint64_t at;
+    bool udp;
+    std::string text;
+};
+
+// Lines of "ms value" for A0, blank lines and # comments skipped
+static bool loadAdcTrace(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[64];
+    unsigned long ms;
+    int value;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%lu %d", &ms, &value) == 2)
+            sim_adc_trace(A0_PIN, ms * 1000ULL, value);
+    }
+    fclose(f);
+    return true;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double p) {
+    size_t i = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+int main(int argc, char **argv) {
+    uint32_t run_seconds = 600;
+    std::vector<scripted_input> script;
+    uint64_t next_serial = 1000000, next_udp = 1500000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            run_seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+            sim_set_wrap_offset(atoi(argv[++i]) * 1000);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            script.push_back({next_serial, false, std::string(argv[++i]) + "\r"});
+            next_serial += 1000000;
+        }
+        else if (!strcmp(argv[i], "-u") && i + 1 < argc) {
+            script.push_back({next_udp, true, argv[++i]});
+            next_udp += 1000000;
+        }
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc) {
+            // Binary packet given as hex bytes, e.g. "b5 01 0a 07 00"
+            std::string packet;
+            for (char *p = argv[++i]; *p; ) {
+                char *end;
+                long b = strtol(p, &end, 16);
+                if (end == p)
+                    break;
+                packet.push_back((char)b);
+                p = end;
+            }
+            script.push_back({next_udp, true, packet});
+            next_udp += 1000000;
+        }
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            if (!loadAdcTrace(argv[++i]))
+                return 2;
+        }
+        else if (!strcmp(argv[i], "-v"))
+            sim_set_echo(true);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+            return runBenchmark(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-t seconds] [-w seconds] [-c cmd]... "
+                    "[-u cmd]... [-x hex]... [-a trace] [-v] | -b benchmark\n", argv[0]);
+            return 2;
+        }
+    }
+    std::sort(script.begin(), script.end(),
+            [](const scripted_input &a, const scripted_input &b) { return a.at < b.at; });
+
+    setup();
+    uint64_t setup_us = sim_clock();
+
+    std::vector<uint32_t> latency;
+    uint64_t end = setup_us + run_seconds * 1000000ULL;
+    size_t next_input = 0;
+    while (sim_clock() < end) {
+        while (next_input < script.size() && script[next_input].at <= sim_clock()) {
+            const scripted_input &in = script[next_input++];
+            if (in.udp)
+                sim_udp_inject(in.text.data(), in.text.size());
+            else
+                sim_serial_inject(in.text.c_str());
+        }
+        uint64_t start = sim_clock();
+        uint64_t idle = sim_devices[SIM_IDLE].us;
+        sim_advance(LOOP_OVERHEAD_US);
+        loop();
+        latency.push_back(sim_clock() - start - (sim_devices[SIM_IDLE].us - idle));
+    }
+
+    uint64_t total = 0;
+    for (uint32_t l : latency)
+        total += l;
+    std::sort(latency.begin(), latency.end());
+
+    printf("\nsetup(): %llu us\n", (unsigned long long)setup_us);
+    printf("loop(): %zu iterations over %u s virtual time\n", latency.size(), run_seconds);
+    printf("  mean %llu us  p50 %u  p90 %u  p99 %u  p99.9 %u  max %u us\n",
+            (unsigned long long)(total / latency.size()),
+            percentile(latency, 50), percentile(latency, 90),
+            percentile(latency, 99), percentile(latency, 99.9),
+            latency.back());
+    printf("\n%-10s %10s %10s %12s %7s\n", "device", "calls", "bytes", "blocked us", "share");
+    for (int d = 0; d < SIM_DEVICE_COUNT; d++) {
+        const sim_device &dev = sim_devices[d];
+        printf("%-10s %10u %10u %12llu %6.2f%%\n", dev.name, dev.calls, dev.bytes,
+                (unsigned long long)dev.us, 100.0 * dev.us / sim_clock());
+    }
+    return 0;
+}
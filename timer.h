@@ -0,0 +1,41 @@
+// timer.h
+/* Rollover-safe timing shared by all modules. millis() wraps every ~49.7
+        days, so stamps are only ever compared through their unsigned
+        difference, never with < or > on the raw values. Intervals must stay
+        under 2^31 ms (~24.8 days). */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <Arduino.h>
+
+// Measures time since it was last restarted
+class elapsed_timer
+{
+    private:
+        uint32_t start = 0;
+    public:
+        void restart() { start = millis(); }
+
+        // Milliseconds since restart()
+        uint32_t elapsed() const { return millis() - start; }
+
+        bool hasElapsed(uint32_t ms) const { return elapsed() >= ms; }
+};
+
+// A point in time something is due at
+class deadline
+{
+    private:
+        uint32_t at = 0;
+    public:
+        // Due the given number of ms from now
+        void set(uint32_t in) { at = millis() + in; }
+
+        // Push the deadline back by a period without drifting
+        void advance(uint32_t period) { at += period; }
+
+        // Milliseconds past due, negative while still ahead
+        int32_t late() const { return (int32_t)(millis() - at); }
+};
+
+#endif
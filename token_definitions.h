@@ -24,6 +24,7 @@
 #define t_MONITOR 22
 #define t_INFO 23
 #define t_SCALE 24
+#define t_TASKS 25
 
 #define t_BYTE 26
 #define t_WORD 27
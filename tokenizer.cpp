@@ -0,0 +1,81 @@
+// tokenizer.cpp
+#include "tokenizer.h"
+
+#define KEYWORD_SLOTS 32 // Power of two so the hash reduces with a mask
+#define l_KEYWORD 8      // Longest keyword 7 "version" + NUL
+
+struct keyword_entry {
+    char word[l_KEYWORD];
+    uint8_t token;
+};
+
+/* Perfect hash over the keywords: every keyword lands in its own slot so a
+        lookup is one hash and one full string compare, whatever the word.
+    The multipliers were found by brute force search over the keyword list.
+        If a new keyword collides the static_assert below fails, search again
+        for (a*first + b*second + c*length) % KEYWORD_SLOTS without collisions
+        and re-lay the table in slot order. */
+constexpr uint8_t keywordSlot(char first, char second, uint8_t len) {
+    return (2 * first + 15 * second + 7 * len) & (KEYWORD_SLOTS - 1);
+}
+
+constexpr uint8_t keywordLength(const char *w) {
+    return *w ? 1 + keywordLength(w + 1) : 0;
+}
+
+constexpr uint8_t keywordSlot(const char *w) {
+    return keywordSlot(w[0], w[1], keywordLength(w));
+}
+
+// Indexed by keywordSlot()
+constexpr keyword_entry keywords[KEYWORD_SLOTS] PROGMEM = {
+    {"info", t_INFO},         // 0
+    {"", TOKEN_NONE},
+    {"rgb", t_RGB},           // 2
+    {"", TOKEN_NONE},
+    {"red", t_RED},           // 4
+    {"", TOKEN_NONE},
+    {"set", t_SET},           // 6
+    {"yellow", t_YELLOW},     // 7
+    {"version", t_VERSION},   // 8
+    {"", TOKEN_NONE},
+    {"", TOKEN_NONE},
+    {"time", t_TIME},         // 11
+    {"monitor", t_MONITOR},   // 12
+    {"off", t_OFF},           // 13
+    {"log", t_LOG},           // 14
+    {"", TOKEN_NONE},
+    {"", TOKEN_NONE},
+    {"", TOKEN_NONE},
+    {"", TOKEN_NONE},
+    {"date", t_DATE},         // 19
+    {"", TOKEN_NONE},
+    {"dht", t_DHT},           // 21
+    {"scale", t_SCALE},       // 22
+    {"help", t_HELP},         // 23
+    {"led", t_LED},           // 24
+    {"", TOKEN_NONE},
+    {"tasks", t_TASKS},       // 26
+    {"blink", t_BLINK},       // 27
+    {"", TOKEN_NONE},
+    {"clear", t_CLEAR},       // 29
+    {"on", t_ON},             // 30
+    {"green", t_GREEN}        // 31
+};
+
+constexpr bool slotsInOrder(uint8_t i) {
+    return i == KEYWORD_SLOTS ||
+        ((keywords[i].word[0] == '\0' || keywordSlot(keywords[i].word) == i) &&
+            slotsInOrder(i + 1));
+}
+static_assert(slotsInOrder(0), "keywords[] is not in keywordSlot() order");
+
+uint8_t lookupToken(const char *word, uint8_t len) {
+    // Every keyword is 2 to 7 chars, also keeps the compare in bounds
+    if (len < 2 || len >= l_KEYWORD)
+        return TOKEN_NONE;
+    const keyword_entry *e = &keywords[keywordSlot(word[0], word[1], len)];
+    if (strncmp_P(word, e->word, l_KEYWORD) != 0)
+        return TOKEN_NONE;
+    return pgm_read_byte(&e->token);
+}
@@ -0,0 +1,18 @@
+// tokenizer.h
+/* Keyword to token lookup for the command line parser. */
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <Arduino.h>
+#include "token_definitions.h"
+
+#define TOKEN_NONE 255
+// Token buffer length, the longest command is
+//  SET TIME BYTE 12 BYTE 30 BYTE 45 EOL
+#define l_TOKEN_BUFFER 9
+
+// Return the token for a NUL terminated lowercase word of the given
+//  length, or TOKEN_NONE if it is not a keyword
+uint8_t lookupToken(const char*, uint8_t);
+
+#endif